@@ -24,6 +24,7 @@ def _init(
         vel: Tuple[float, float] = (0.0, 0.0),
         omega: float = 0.0,
         dump_surface: int = 0,
+        forces_freq: int = 1,
         time_forced: float = 1e100):
     """Helper function for initializing shapes.
 
@@ -43,6 +44,7 @@ def _init(
         'yvel': vel[1],
         'angvel': omega,
         'dumpSurf': dump_surface,
+        'forcesFreq': forces_freq,
         'timeForced': time_forced,
     }
     conflict = kwargv.keys() & _kwargv.keys()
@@ -86,4 +88,4 @@ class StefanFish(lib._StefanFish):
     __slots__ = ()
     def __init__(self, sim: Simulation, pid: int, pidpos: int, **kwargs):
         """Construct a StefanFish with required PID control `pid` and `pidpos`."""
-        _init(lib._StefanFish, self, sim, dict(bCorrectTrajectory=pid, bCorrectPosition=pidpos), **kwargs)
+        _init(lib._StefanFish, self, sim, dict(pid=pid, pidpos=pidpos), **kwargs)
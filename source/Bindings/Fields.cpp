@@ -109,6 +109,9 @@ struct BlockView
 template <typename Grid>
 struct GridBlocksView
 {
+  static constexpr bool kIsVector = std::is_same_v<Grid, VectorGrid>;
+  static constexpr ssize_t kBlockBytes = BS * BS * (kIsVector ? 2 : 1) * sizeof(Real);
+
   Grid *grid;
 
   size_t numBlocks() const
@@ -118,9 +121,132 @@ struct GridBlocksView
 
   BlockView getBlock(size_t k) const
   {
-      static constexpr bool kIsVector = std::is_same_v<Grid, VectorGrid>;
       return BlockView{&grid->getBlocksInfo().at(k), kIsVector};
   }
+
+  /// Distance in bytes between consecutive local blocks if they are equally
+  /// spaced in memory (the usual case right after allocation), 0 otherwise.
+  ssize_t blockStride() const
+  {
+    const auto &infos = grid->getBlocksInfo();
+    if (infos.size() < 2)
+      return kBlockBytes;
+    const char * const first = (const char *)infos[0].ptrBlock;
+    const ssize_t stride = (const char *)infos[1].ptrBlock - first;
+    if (std::abs(stride) < kBlockBytes)
+      return 0;
+    for (size_t k = 2; k < infos.size(); ++k)
+      if ((const char *)infos[k].ptrBlock - first != (ssize_t)k * stride)
+        return 0;
+    return stride;
+  }
+
+  /// All local blocks as one (num_blocks, BS, BS[, 2]) array. Zero-copy and
+  /// writable if the blocks are equally spaced in memory, otherwise a
+  /// read-only copy (use `load` to write). Invalidated by mesh adaptation.
+  py::array_t<Real> data() const
+  {
+    const auto &infos = grid->getBlocksInfo();
+    const ssize_t nb = (ssize_t)infos.size();
+    constexpr ssize_t size = sizeof(Real);
+    std::vector<ssize_t> shape{nb, BS, BS};
+    std::vector<ssize_t> strides{kBlockBytes, (kIsVector ? 2 : 1) * BS * size,
+                                 (kIsVector ? 2 : 1) * size};
+    if (kIsVector) {
+      shape.push_back(2);
+      strides.push_back(size);
+    }
+
+    const ssize_t stride = blockStride();
+    if (nb > 0 && stride != 0) {
+      strides[0] = stride;
+      // The capsule only marks the array as not owning its data.
+      return py::array_t<Real>(shape, strides, (Real *)infos[0].ptrBlock,
+                               py::capsule(infos[0].ptrBlock, [](void *) {}));
+    }
+
+    py::array_t<Real> out(shape);
+    char * const ptr = (char *)out.mutable_data();
+    #pragma omp parallel for
+    for (ssize_t k = 0; k < nb; ++k)
+      memcpy(ptr + k * kBlockBytes, infos[k].ptrBlock, kBlockBytes);
+    out.attr("setflags")("write"_a = false);
+    return out;
+  }
+
+  /// Copy a (num_blocks, BS, BS[, 2]) array into the blocks.
+  void load(py::array_t<Real, py::array::c_style | py::array::forcecast> array) const
+  {
+    const auto &infos = grid->getBlocksInfo();
+    const ssize_t nb = (ssize_t)infos.size();
+    const bool ok = array.ndim() == (kIsVector ? 4 : 3)
+        && array.shape(0) == nb
+        && array.shape(1) == BS
+        && array.shape(2) == BS
+        && (!kIsVector || array.shape(3) == 2);
+    if (!ok) {
+      py::tuple expected = kIsVector ? py::make_tuple(nb, BS, BS, 2)
+                                     : py::make_tuple(nb, BS, BS);
+      throw py::type_error("expected shape {}"_s.format(expected));
+    }
+    const char * const ptr = (const char *)array.data();
+    #pragma omp parallel for
+    for (ssize_t k = 0; k < nb; ++k)
+      if (infos[k].ptrBlock != ptr + k * kBlockBytes)  // not our own view
+        memmove(infos[k].ptrBlock, ptr + k * kBlockBytes, kBlockBytes);
+  }
+
+  /// One entry per block, in the same order as `data`.
+  template <typename T, int N, typename Func>
+  py::array_t<T> perBlock(Func func) const
+  {
+    const auto &infos = grid->getBlocksInfo();
+    std::vector<ssize_t> shape{(ssize_t)infos.size()};
+    if (N > 1)
+      shape.push_back(N);
+    py::array_t<T> out(shape);
+    T * const ptr = out.mutable_data();
+    for (size_t k = 0; k < infos.size(); ++k)
+      func(infos[k], ptr + N * k);
+    return out;
+  }
+
+  py::array_t<int> levels() const
+  {
+    return perBlock<int, 1>([](const cubism::BlockInfo &info, int *out) {
+      out[0] = info.level;
+    });
+  }
+
+  py::array_t<long long> Z() const
+  {
+    return perBlock<long long, 1>([](const cubism::BlockInfo &info, long long *out) {
+      out[0] = info.Z;
+    });
+  }
+
+  py::array_t<int> ij() const
+  {
+    return perBlock<int, 2>([](const cubism::BlockInfo &info, int *out) {
+      out[0] = info.index[0];
+      out[1] = info.index[1];
+    });
+  }
+
+  py::array_t<double> origins() const
+  {
+    return perBlock<double, 2>([](const cubism::BlockInfo &info, double *out) {
+      out[0] = info.origin[0];
+      out[1] = info.origin[1];
+    });
+  }
+
+  py::array_t<double> spacings() const
+  {
+    return perBlock<double, 1>([](const cubism::BlockInfo &info, double *out) {
+      out[0] = info.h;
+    });
+  }
 };
 
 }  // anonymous namespace
@@ -186,7 +312,21 @@ static void bindGrid(py::module &m, const char *name, const char *blocksViewName
   using View = GridBlocksView<Grid>;
   py::class_<View>(m, blocksViewName)
     .def("__len__", &View::numBlocks, "number of blocks of a grid")
-    .def("__getitem__", &View::getBlock);
+    .def("__getitem__", &View::getBlock)
+    .def_property_readonly("data", &View::data,
+         "all local blocks as one (num_blocks, BS, BS[, 2]) array, zero-copy "
+         "if `contiguous`, otherwise a read-only copy")
+    .def_property_readonly("contiguous",
+         [](const View &view) { return view.blockStride() != 0; },
+         "whether `data` is a writable zero-copy view")
+    .def("load", &View::load, "array"_a,
+         "copy a (num_blocks, BS, BS[, 2]) array into the blocks")
+    .def_property_readonly("levels", &View::levels, "level of each block")
+    .def_property_readonly("Z", &View::Z, "Z-order index of each block")
+    .def_property_readonly("ij", &View::ij, "(num_blocks, 2) block indices")
+    .def_property_readonly("origins", &View::origins,
+         "(num_blocks, 2) coordinates of the lower-left corner of each block")
+    .def_property_readonly("h", &View::spacings, "cell size of each block");
 
   py::class_<Grid>(m, name)
     .def_property_readonly("blocks", [](Grid *grid) { return View{grid}; })
@@ -1,5 +1,6 @@
 #include "Common.h"
 #include "../Poisson/AMRSolver.h"
+#include "../Poisson/SStepSolver.h"
 #include "../SimulationData.h"
 
 namespace cubismup2d {
@@ -12,6 +13,9 @@ void bindPoissonSolvers(py::module &m)
 
   class_shared<AMRSolver, PoissonSolver>(m, "AMRSolver")
     .def(py::init<SimulationData &>(), "data"_a);
+
+  class_shared<SStepSolver, AMRSolver>(m, "SStepSolver")
+    .def(py::init<SimulationData &>(), "data"_a);
 }
 
 }  // namespace cubismup2d
@@ -4,6 +4,7 @@
 #include "../SimulationData.h"
 #include "../Utils/FactoryFileLineParser.h"
 #include "Common.h"
+#include <pybind11/numpy.h>
 #include <sstream>
 
 using namespace pybind11::literals;
@@ -37,6 +38,35 @@ static auto xyToPair(const Real Shape:: *x, const Real Shape:: *y)
   };
 }
 
+using FishList = std::vector<std::shared_ptr<StefanFish>>;
+
+/// States of all fish as one (num_fish, 16) array (collective).
+static py::array_t<Real> stefanFishStates(const FishList &fish, const std::vector<double> &origin)
+{
+  std::vector<const StefanFish *> ptrs;
+  for (const auto &f : fish)
+    ptrs.push_back(f.get());
+  const std::vector<std::vector<Real>> S = StefanFish::states(ptrs, origin);
+  const ssize_t dim = S.empty() ? 16 : (ssize_t)S[0].size();
+  py::array_t<Real> out(std::vector<ssize_t>{(ssize_t)S.size(), dim});
+  Real * const ptr = out.mutable_data();
+  for (size_t i = 0; i < S.size(); ++i)
+    std::copy(S[i].begin(), S[i].end(), ptr + i * dim);
+  return out;
+}
+
+/// Apply the rows of a (num_fish, action_dim) array as actions.
+static void stefanFishAct(const FishList &fish, Real t,
+                          py::array_t<Real, py::array::c_style | py::array::forcecast> actions)
+{
+  if (actions.ndim() != 2 || actions.shape(0) != (ssize_t)fish.size())
+    throw py::type_error("expected an array of shape (num_fish, action_dim)");
+  const ssize_t dim = actions.shape(1);
+  const Real * const ptr = actions.data();
+  for (size_t i = 0; i < fish.size(); ++i)
+    fish[i]->act(t, std::vector<Real>(ptr + i * dim, ptr + (i + 1) * dim));
+}
+
 void bindShapes(py::module &m)
 {
   class_shared<Shape>(m, "_Shape")
@@ -52,7 +82,9 @@ void bindShapes(py::module &m)
     .def_property_readonly("force_V", xyToPair(&Shape::forcex_V, &Shape::forcey_V))
     .def_readonly("drag", &Shape::drag)
     .def_readonly("thrust", &Shape::thrust)
-    .def_readonly("lift", &Shape::lift);
+    .def_readonly("lift", &Shape::lift)
+    .def("request_forces", &Shape::requestForces,
+         "Compute the surface forces at the next step (for shapes with forcesFreq != 1)");
 
   bindShape<Disk>(m, "_Disk")
     .def_property_readonly("r", &Disk::getRadius);
@@ -63,6 +95,13 @@ void bindShapes(py::module &m)
     .def("act", &StefanFish::act, "Set Action")
     .def("state", &StefanFish::state, "Get State")
     .def_readonly("efficiency", &StefanFish::EffPDefBnd);
+
+  m.def("stefanfish_states", &stefanFishStates, "fish"_a, "origin"_a,
+        "States of all fish as a (num_fish, 16) array, equal to calling "
+        "`state(origin)` of each one but with a single grid traversal and "
+        "reduction for all sensors (collective)");
+  m.def("stefanfish_act", &stefanFishAct, "fish"_a, "t"_a, "actions"_a,
+        "Call `act(t, actions[i])` of every fish i");
 }
 
 }  // namespace cubismup2d
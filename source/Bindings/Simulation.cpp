@@ -48,6 +48,11 @@ void bindSimulationData(py::module &m)
       .def_readwrite("mute_all", &SimulationData::muteAll)
       .def_readwrite("nu", &SimulationData::nu);
 
+  // Total Poisson solver iterations of the completed steps (see PerfReport).
+  pyData.def_property_readonly("poisson_iterations", [](const SimulationData &d) {
+        return d.perf->getPoissonTotals().iterations;
+      });
+
   // Bind all grids. If updating this, update properties in
   // cubismup2d/simulation.py as well.
   const auto byRef = py::return_value_policy::reference_internal;
@@ -111,6 +116,10 @@ static void pyComputeVorticity(Simulation &sim)
 
 void bindSimulation(py::module &m)
 {
+  class_shared<SimulationSnapshot>(m, "SimulationSnapshot")
+      .def_readonly("time", &SimulationSnapshot::time)
+      .def_readonly("step", &SimulationSnapshot::step);
+
   class_shared<Simulation>(m, "_Simulation")
       .def(py::init(&pyCreateSimulation), "argv"_a, "comm"_a = 0)
       .def_readonly("data", &Simulation::sim,
@@ -125,7 +134,17 @@ void bindSimulation(py::module &m)
       .def("compute_vorticity", &pyComputeVorticity,
            "compute the vorticity and store it to the tmp field")
       .def("init", &Simulation::init)
-      .def("simulate", &Simulation::simulate);
+      .def("snapshot", &Simulation::snapshot,
+           "copy the mesh, the fields, the shapes and the time to memory")
+      .def("restore", &Simulation::restore, "snapshot"_a,
+           "return to a snapshot without recomputing the initial mesh")
+      .def("simulate", [](Simulation *sim) {
+        // vel may have been written from Python since the last step, through
+        // load_uniform, blocks.load or the writable views blocks.data and
+        // BlockView.data, which cannot be tracked individually.
+        sim->sim.invalidateVel();
+        sim->simulate();
+      });
 }
 
 }  // namespace cubismup2d
@@ -43,6 +43,7 @@ class AmplitudeFish : public FishData
   : FishData(L, _h),  phaseShift(phi),  Tperiod(T) { _computeWidth(); }
 
   void computeMidline(const Real time, const Real dt) override;
+  bool distributeMidline() const override { return true; }
   Real _width(const Real s, const Real L) override
   {
     const Real sb=.04*length, st=.95*length, wt=.01*length, wh=.04*length;
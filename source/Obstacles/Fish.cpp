@@ -24,7 +24,8 @@ void Fish::create(const std::vector<BlockInfo>& vInfo)
   //// 1) Update Midline and compute surface
   assert(myFish!=nullptr);
   profile(push_start("midline"));
-  myFish->computeMidline(sim.time, sim.dt);
+  if (!midlineReady) myFish->computeMidline(sim.time, sim.dt);
+  midlineReady = false;
   myFish->computeSurface();
   profile(pop_stop());
 
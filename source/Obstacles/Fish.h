@@ -15,6 +15,9 @@ class Fish: public Shape
  public:
   const Real length, Tperiod, phaseShift;
   FishData * myFish = nullptr;
+  // set if the midline for the current step was already computed (or
+  // received from another rank), see PutObjectsOnGrid::computeMidlines
+  bool midlineReady = false;
  protected:
   Real area_internal = 0, J_internal = 0;
   Real CoM_internal[2] = {0, 0}, vCoM_internal[2] = {0, 0};
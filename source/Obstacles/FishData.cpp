@@ -591,7 +591,34 @@ void PutFishOnBlocks::constructInternl(const BlockInfo& info, ScalarBlock& b,
       //here we process also all inner points. Nw to the left and right of midl
       // add xtension here to make sure we have it in each direction:
       const int Nw = std::floor(myWidth/h); //floor bcz we already did interior
-      for(int iw = -Nw+1; iw < Nw; ++iw)
+
+      // The points of the slice lie on the line x0 + iw*h*nor; only the range
+      // of iw whose 2x2 stencil touches this block is visited (padded by one
+      // point, the exact test is done below), so that a slice costs only the
+      // points that land in the block instead of its full width.
+      int iwStart = -Nw+1, iwEnd = Nw;
+      {
+        Real x0[2] = { cfish.rX[ss], cfish.rY[ss] };
+        changeToComputationalFrame(x0);
+        Real dir[2] = { cfish.norX[ss], cfish.norY[ss] };
+        changeVelocityToComputationalFrame(dir);
+        for(int c=0; c<2; ++c)
+        {
+          // stencil touches the block if -1 <= (x0 + iw*h*dir - org)*invh < BS
+          const Real X0 = (x0[c]-org[c])*invh, lo = -1, hi = BS[c];
+          if (std::fabs(dir[c]) < 1e-12) {
+            if (X0 < lo || X0 >= hi) iwEnd = iwStart;
+            continue;
+          }
+          const Real a = (lo - X0)/dir[c], b = (hi - X0)/dir[c];
+          const Real first = std::floor(std::min(a,b)) - 1;
+          const Real last  = std::ceil (std::max(a,b)) + 1;
+          if (first > iwStart) iwStart = (int)std::min(first, (Real)Nw);
+          if (last  < iwEnd  ) iwEnd   = (int)std::max(last, (Real)-Nw);
+        }
+      }
+
+      for(int iw = iwStart; iw < iwEnd; ++iw)
       {
         const Real offsetW = iw * h;
         Real xp[2] = { cfish.rX[ss] + offsetW*cfish.norX[ss],
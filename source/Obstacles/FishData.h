@@ -143,6 +143,16 @@ struct FishData
   void writeMidline2File(const int step_id, std::string filename);
 
   virtual void computeMidline(const Real time, const Real dt) = 0;
+
+  // With -bDistributeMidlines (see PutObjectsOnGrid::computeMidlines) every
+  // rank calls updateGait, which advances the gait state (schedulers, phase),
+  // and only the owning rank calls solveMidline, which fills the midline
+  // arrays. computeMidline must be equivalent to the two calls. Fish whose
+  // midline keeps state without this split return false and are computed
+  // locally on every rank.
+  virtual bool distributeMidline() const { return false; }
+  virtual void updateGait(const Real time, const Real dt) {}
+  virtual void solveMidline(const Real time, const Real dt) { computeMidline(time, dt); }
 };
 
 struct AreaSegment
@@ -20,6 +20,8 @@ class NacaData : public FishData
     _computeWidth();
   }
 
+  bool distributeMidline() const override { return true; }
+
   void computeMidline(const Real time, const Real dt) override
   {
     rX[0] = rY[0] = vX[0] = vY[0] = norX[0] = vNorX[0] = vNorY[0] = 0.0;
@@ -5,6 +5,7 @@
 //
 
 #include "StefanFish.h"
+#include "../Utils/SensorGather.h"
 #include <sstream>
 #include <iomanip>
 
@@ -20,7 +21,6 @@ void StefanFish::resetAll() {
 void StefanFish::saveRestart( FILE * f ) {
   assert(f != NULL);
   Fish::saveRestart(f);
-  CurvatureFish* const cFish = dynamic_cast<CurvatureFish*>( myFish );
   std::stringstream ss;
   ss<<std::setfill('0')<<std::setw(7)<<"_"<<obstacleID<<"_";
   std::string filename = "Schedulers"+ ss.str() + ".restart";
@@ -29,82 +29,130 @@ void StefanFish::saveRestart( FILE * f ) {
      savestream.setf(std::ios::scientific);
      savestream.precision(std::numeric_limits<Real>::digits10 + 1);
      savestream.open(filename);
-     {
-       const auto & c = cFish->curvatureScheduler;
-       savestream << c.t0 << "\t" << c.t1 << std::endl;
-       for(int i=0;i<c.npoints;++i)
-         savestream << c.parameters_t0[i]  << "\t"
-                    << c.parameters_t1[i]  << "\t"
-                    << c.dparameters_t0[i] << std::endl;
-     }
-     {
-       const auto & c = cFish->periodScheduler;
-       savestream << c.t0 << "\t" << c.t1 << std::endl;
-       for(int i=0;i<c.npoints;++i)
-         savestream << c.parameters_t0[i]  << "\t"
-                    << c.parameters_t1[i]  << "\t"
-                    << c.dparameters_t0[i] << std::endl;
-     }
-     {
-      const auto & c = cFish->rlBendingScheduler;
-       savestream << c.t0 << "\t" << c.t1 << std::endl;
-       for(int i=0;i<c.npoints;++i)
-         savestream << c.parameters_t0[i]  << "\t"
-                    << c.parameters_t1[i]  << "\t"
-                    << c.dparameters_t0[i] << std::endl;
-     }
+     saveSchedulers(savestream);
      savestream.close();
   }
-
-  //Save these numbers for PID controller and other stuff. Maybe not all of them are needed
-  //but we don't care, it's only a few numbers.
-  fprintf(f, "curv_PID_fac: %20.20e\n", (double)cFish->curv_PID_fac);
-  fprintf(f, "curv_PID_dif: %20.20e\n", (double)cFish->curv_PID_dif);
-  fprintf(f, "avgDeltaY   : %20.20e\n", (double)cFish->avgDeltaY   );
-  fprintf(f, "avgDangle   : %20.20e\n", (double)cFish->avgDangle   );
-  fprintf(f, "avgAngVel   : %20.20e\n", (double)cFish->avgAngVel   );
-  fprintf(f, "lastTact    : %20.20e\n", (double)cFish->lastTact    );
-  fprintf(f, "lastCurv    : %20.20e\n", (double)cFish->lastCurv    );
-  fprintf(f, "oldrCurv    : %20.20e\n", (double)cFish->oldrCurv    );
-  fprintf(f, "periodPIDval: %20.20e\n", (double)cFish->periodPIDval);
-  fprintf(f, "periodPIDdif: %20.20e\n", (double)cFish->periodPIDdif);
-  fprintf(f, "time0       : %20.20e\n", (double)cFish->time0       );
-  fprintf(f, "timeshift   : %20.20e\n", (double)cFish->timeshift   );
-  fprintf(f, "lastTime    : %20.20e\n", (double)cFish->lastTime    );
-  fprintf(f, "lastAvel    : %20.20e\n", (double)cFish->lastAvel    );
+  saveControllers(f);
 }
 
 void StefanFish::loadRestart( FILE * f ) {
   assert(f != NULL);
   Fish::loadRestart(f);
-  CurvatureFish* const cFish = dynamic_cast<CurvatureFish*>( myFish );
   std::stringstream ss;
   ss<<std::setfill('0')<<std::setw(7)<<"_"<<obstacleID<<"_";
   std::ifstream restartstream;
   std::string filename = "Schedulers"+ ss.str() + ".restart";
   restartstream.open(filename);
+  loadSchedulers(restartstream);
+  restartstream.close();
+  loadControllers(f);
+}
+
+// The restart files keep the schedulers in a separate file, the snapshot
+// appends them to the rest of the state.
+std::string StefanFish::snapshot() {
+  char * buffer = nullptr;
+  size_t size = 0;
+  FILE * f = open_memstream(&buffer, &size);
+  Fish::saveRestart(f);
+  saveControllers(f);
+  fclose(f);
+  std::string state(buffer, size);
+  free(buffer);
+  std::ostringstream schedulers;
+  schedulers.setf(std::ios::scientific);
+  schedulers.precision(std::numeric_limits<Real>::max_digits10);
+  saveSchedulers(schedulers);
+  return state + schedulers.str();
+}
+
+void StefanFish::restore( const std::string & state ) {
+  FILE * f = fmemopen((void *)state.data(), state.size(), "r");
+  Fish::loadRestart(f);
+  loadControllers(f);
+  std::istringstream schedulers(state.substr(ftell(f)));
+  fclose(f);
+  loadSchedulers(schedulers);
+}
+
+void StefanFish::saveSchedulers( std::ostream & out ) const {
+  const CurvatureFish* const cFish = dynamic_cast<CurvatureFish*>( myFish );
+  {
+    const auto & c = cFish->curvatureScheduler;
+    out << c.t0 << "\t" << c.t1 << std::endl;
+    for(int i=0;i<c.npoints;++i)
+      out << c.parameters_t0[i]  << "\t"
+          << c.parameters_t1[i]  << "\t"
+          << c.dparameters_t0[i] << std::endl;
+  }
+  {
+    const auto & c = cFish->periodScheduler;
+    out << c.t0 << "\t" << c.t1 << std::endl;
+    for(int i=0;i<c.npoints;++i)
+      out << c.parameters_t0[i]  << "\t"
+          << c.parameters_t1[i]  << "\t"
+          << c.dparameters_t0[i] << std::endl;
+  }
+  {
+    const auto & c = cFish->rlBendingScheduler;
+    out << c.t0 << "\t" << c.t1 << std::endl;
+    for(int i=0;i<c.npoints;++i)
+      out << c.parameters_t0[i]  << "\t"
+          << c.parameters_t1[i]  << "\t"
+          << c.dparameters_t0[i] << std::endl;
+  }
+}
+
+void StefanFish::loadSchedulers( std::istream & in ) {
+  CurvatureFish* const cFish = dynamic_cast<CurvatureFish*>( myFish );
   {
      auto & c = cFish->curvatureScheduler;
-     restartstream >> c.t0 >> c.t1;
+     in >> c.t0 >> c.t1;
      for(int i=0;i<c.npoints;++i)
-       restartstream >> c.parameters_t0[i] >> c.parameters_t1[i] >> c.dparameters_t0[i];
+       in >> c.parameters_t0[i] >> c.parameters_t1[i] >> c.dparameters_t0[i];
   }
   {
      auto & c = cFish->periodScheduler;
-     restartstream >> c.t0 >> c.t1;
+     in >> c.t0 >> c.t1;
      for(int i=0;i<c.npoints;++i)
-       restartstream >> c.parameters_t0[i] >> c.parameters_t1[i] >> c.dparameters_t0[i];
+       in >> c.parameters_t0[i] >> c.parameters_t1[i] >> c.dparameters_t0[i];
   }
   {
      auto & c = cFish->rlBendingScheduler;
-     restartstream >> c.t0 >> c.t1;
+     in >> c.t0 >> c.t1;
      for(int i=0;i<c.npoints;++i)
-       restartstream >> c.parameters_t0[i] >> c.parameters_t1[i] >> c.dparameters_t0[i];
+       in >> c.parameters_t0[i] >> c.parameters_t1[i] >> c.dparameters_t0[i];
   }
-  restartstream.close();
+}
+
+void StefanFish::saveControllers( FILE * f ) const {
+  const CurvatureFish* const cFish = dynamic_cast<CurvatureFish*>( myFish );
+  //Save these numbers for PID controller and other stuff. Maybe not all of them are needed
+  //but we don't care, it's only a few numbers.
+  fprintf(f, "curv_PID_fac: %20.20e\n", (double)cFish->curv_PID_fac);
+  fprintf(f, "curv_PID_dif: %20.20e\n", (double)cFish->curv_PID_dif);
+  fprintf(f, "avgDeltaY   : %20.20e\n", (double)cFish->avgDeltaY   );
+  fprintf(f, "avgDangle   : %20.20e\n", (double)cFish->avgDangle   );
+  fprintf(f, "avgAngVel   : %20.20e\n", (double)cFish->avgAngVel   );
+  fprintf(f, "lastTact    : %20.20e\n", (double)cFish->lastTact    );
+  fprintf(f, "lastCurv    : %20.20e\n", (double)cFish->lastCurv    );
+  fprintf(f, "oldrCurv    : %20.20e\n", (double)cFish->oldrCurv    );
+  fprintf(f, "periodPIDval: %20.20e\n", (double)cFish->periodPIDval);
+  fprintf(f, "periodPIDdif: %20.20e\n", (double)cFish->periodPIDdif);
+  fprintf(f, "time0       : %20.20e\n", (double)cFish->time0       );
+  fprintf(f, "timeshift   : %20.20e\n", (double)cFish->timeshift   );
+  fprintf(f, "lastTime    : %20.20e\n", (double)cFish->lastTime    );
+  fprintf(f, "lastAvel    : %20.20e\n", (double)cFish->lastAvel    );
+  fprintf(f, "current_period     : %20.20e\n", (double)cFish->current_period     );
+  fprintf(f, "next_period        : %20.20e\n", (double)cFish->next_period        );
+  fprintf(f, "transition_start   : %20.20e\n", (double)cFish->transition_start   );
+  fprintf(f, "transition_duration: %20.20e\n", (double)cFish->transition_duration);
+}
 
+void StefanFish::loadControllers( FILE * f ) {
+  CurvatureFish* const cFish = dynamic_cast<CurvatureFish*>( myFish );
   bool ret = true;
-  double in_curv_PID_fac, in_curv_PID_dif, in_avgDeltaY, in_avgDangle, in_avgAngVel, in_lastTact, in_lastCurv, in_oldrCurv, in_periodPIDval, in_periodPIDdif, in_time0, in_timeshift, in_lastTime, in_lastAvel; 
+  double in_curv_PID_fac, in_curv_PID_dif, in_avgDeltaY, in_avgDangle, in_avgAngVel, in_lastTact, in_lastCurv, in_oldrCurv, in_periodPIDval, in_periodPIDdif, in_time0, in_timeshift, in_lastTime, in_lastAvel, in_current_period, in_next_period, in_transition_start, in_transition_duration;
   ret = ret && 1==fscanf(f, "curv_PID_fac: %le\n", &in_curv_PID_fac);
   ret = ret && 1==fscanf(f, "curv_PID_dif: %le\n", &in_curv_PID_dif);
   ret = ret && 1==fscanf(f, "avgDeltaY   : %le\n", &in_avgDeltaY   );
@@ -119,6 +167,17 @@ void StefanFish::loadRestart( FILE * f ) {
   ret = ret && 1==fscanf(f, "timeshift   : %le\n", &in_timeshift   );
   ret = ret && 1==fscanf(f, "lastTime    : %le\n", &in_lastTime    );
   ret = ret && 1==fscanf(f, "lastAvel    : %le\n", &in_lastAvel    );
+  // the period transition is missing from restart files written before it
+  // was saved, those keep the defaults of resetAll
+  in_current_period = in_next_period = cFish->Tperiod;
+  in_transition_start = 0;
+  in_transition_duration = 0.1*cFish->Tperiod;
+  if (1==fscanf(f, "current_period     : %le\n", &in_current_period     ))
+  {
+    ret = ret && 1==fscanf(f, "next_period        : %le\n", &in_next_period        );
+    ret = ret && 1==fscanf(f, "transition_start   : %le\n", &in_transition_start   );
+    ret = ret && 1==fscanf(f, "transition_duration: %le\n", &in_transition_duration);
+  }
   cFish->curv_PID_fac = (Real) in_curv_PID_fac;
   cFish->curv_PID_dif = (Real) in_curv_PID_dif;
   cFish->avgDeltaY    = (Real) in_avgDeltaY   ;
@@ -133,6 +192,10 @@ void StefanFish::loadRestart( FILE * f ) {
   cFish->timeshift    = (Real) in_timeshift   ;
   cFish->lastTime     = (Real) in_lastTime    ;
   cFish->lastAvel     = (Real) in_lastAvel    ;
+  cFish->current_period      = (Real) in_current_period     ;
+  cFish->next_period         = (Real) in_next_period        ;
+  cFish->transition_start    = (Real) in_transition_start   ;
+  cFish->transition_duration = (Real) in_transition_duration;
   if( (not ret) ) {
     printf("Error reading restart file. Aborting...\n");
     fflush(0); abort();
@@ -184,7 +247,9 @@ StefanFish::StefanFish(SimulationData&s, ArgumentParser&p, Real C[2]):
  #endif
 
   const Real ampFac = p("-amplitudeFactor").asDouble(1.0);
-  myFish = new CurvatureFish(length, Tperiod, phaseShift, sim.minH, ampFac);
+  CurvatureFish * const cFish = new CurvatureFish(length, Tperiod, phaseShift, sim.minH, ampFac);
+  cFish->bCacheGait = p("-cacheGait").asInt(0);
+  myFish = cFish;
   if( sim.rank == 0 && s.verbose ) printf("[CUP2D] - CurvatureFish %d %f %f %f %f %f %f\n",myFish->Nm, (double)length,(double)myFish->dSref,(double)myFish->dSmid,(double)sim.minH, (double)Tperiod, (double)phaseShift);
 }
 
@@ -322,23 +387,8 @@ Real StefanFish::getPhase(const Real t) const
   return (phase<0) ? 2*M_PI + phase : phase;
 }
 
-std::vector<Real> StefanFish::state( const std::vector<double>& origin ) const
+StefanFish::Sensors StefanFish::sensors() const
 {
-  const CurvatureFish* const cFish = dynamic_cast<CurvatureFish*>( myFish );
-  std::vector<Real> S(16,0);
-  S[0] = ( center[0] - origin[0] )/ length;
-  S[1] = ( center[1] - origin[1] )/ length;
-  S[2] = getOrientation();
-  S[3] = getPhase( sim.time );
-  S[4] = getU() * Tperiod / length;
-  S[5] = getV() * Tperiod / length;
-  S[6] = getW() * Tperiod;
-  S[7] = cFish->lastTact;
-  S[8] = cFish->lastCurv;
-  S[9] = cFish->oldrCurv;
-
-  //Shear stress computation at three sensors
-  //******************************************
   // Get fish skin
   const auto &DU = myFish->upperSkin;
   const auto &DL = myFish->lowerSkin;
@@ -350,27 +400,82 @@ std::vector<Real> StefanFish::state( const std::vector<double>& origin ) const
       iHeadSide = i;
   assert(iHeadSide>0);
 
+  Sensors s;
   //sensor locations
-  const std::array<Real,2> locFront = {DU.xSurf[0]       , DU.ySurf[0]       };
-  const std::array<Real,2> locUpper = {DU.midX[iHeadSide], DU.midY[iHeadSide]};
-  const std::array<Real,2> locLower = {DL.midX[iHeadSide], DL.midY[iHeadSide]};
-
-  //compute shear stress force (x,y) components
-  std::array<Real,2> shearFront = getShear( locFront );
-  std::array<Real,2> shearUpper = getShear( locLower );
-  std::array<Real,2> shearLower = getShear( locUpper );
+  s.loc[0] = {DU.xSurf[0]       , DU.ySurf[0]       };
+  s.loc[1] = {DU.midX[iHeadSide], DU.midY[iHeadSide]};
+  s.loc[2] = {DL.midX[iHeadSide], DL.midY[iHeadSide]};
 
   //normal vectors at sensor locations (these vectors already have unit length)
   // first point of the two skins is the same normal should be almost the same: take the mean
-  const std::array<Real,2> norFront = {0.5*(DU.normXSurf[0] + DL.normXSurf[0]), 0.5*(DU.normYSurf[0] + DL.normYSurf[0]) };
-  const std::array<Real,2> norUpper = { DU.normXSurf[iHeadSide], DU.normYSurf[iHeadSide]};
-  const std::array<Real,2> norLower = { DL.normXSurf[iHeadSide], DL.normYSurf[iHeadSide]};
+  s.nor[0] = {0.5*(DU.normXSurf[0] + DL.normXSurf[0]), 0.5*(DU.normYSurf[0] + DL.normYSurf[0]) };
+  s.nor[1] = { DU.normXSurf[iHeadSide], DU.normYSurf[iHeadSide]};
+  s.nor[2] = { DL.normXSurf[iHeadSide], DL.normYSurf[iHeadSide]};
 
   //tangent vectors at sensor locations (these vectors already have unit length)
   //signs alternate so that both upper and lower tangent vectors point towards fish tail
-  const std::array<Real,2> tanFront = { norFront[1],-norFront[0]};
-  const std::array<Real,2> tanUpper = {-norUpper[1], norUpper[0]};
-  const std::array<Real,2> tanLower = { norLower[1],-norLower[0]};
+  s.tan[0] = { s.nor[0][1],-s.nor[0][0]};
+  s.tan[1] = {-s.nor[1][1], s.nor[1][0]};
+  s.tan[2] = { s.nor[2][1],-s.nor[2][0]};
+  return s;
+}
+
+std::vector<Real> StefanFish::state( const std::vector<double>& origin ) const
+{
+  //Shear stress computation at three sensors
+  const Sensors s = sensors();
+  const std::array<std::array<Real,2>,3> shear = {getShear(s.loc[0]), getShear(s.loc[1]), getShear(s.loc[2])};
+  return state(origin, s, shear);
+}
+
+std::vector<std::vector<Real>> StefanFish::states(const std::vector<const StefanFish*>& fish, const std::vector<double>& origin)
+{
+  std::vector<Sensors> s(fish.size());
+  std::vector<const StefanFish*> owner;
+  std::vector<std::array<Real,2>> pSurf;
+  for (size_t f = 0; f < fish.size(); f++)
+  {
+    s[f] = fish[f]->sensors();
+    for (int j = 0; j < 3; j++)
+    {
+      owner.push_back(fish[f]);
+      pSurf.push_back(s[f].loc[j]);
+    }
+  }
+  const std::vector<std::array<Real,2>> shear = getShear(owner, pSurf);
+
+  std::vector<std::vector<Real>> S(fish.size());
+  for (size_t f = 0; f < fish.size(); f++)
+    S[f] = fish[f]->state(origin, s[f], {shear[3*f], shear[3*f+1], shear[3*f+2]});
+  return S;
+}
+
+std::vector<Real> StefanFish::state(const std::vector<double>& origin, const Sensors& s, const std::array<std::array<Real,2>,3>& shear) const
+{
+  const CurvatureFish* const cFish = dynamic_cast<CurvatureFish*>( myFish );
+  std::vector<Real> S(16,0);
+  S[0] = ( center[0] - origin[0] )/ length;
+  S[1] = ( center[1] - origin[1] )/ length;
+  S[2] = getOrientation();
+  S[3] = getPhase( sim.time );
+  S[4] = getU() * Tperiod / length;
+  S[5] = getV() * Tperiod / length;
+  S[6] = getW() * Tperiod;
+  S[7] = cFish->lastTact;
+  S[8] = cFish->lastCurv;
+  S[9] = cFish->oldrCurv;
+
+  // shear stress force (x,y) components; the one measured at the lower sensor
+  // is projected on the directions of the upper one and vice versa
+  const std::array<Real,2> & shearFront = shear[0];
+  const std::array<Real,2> & shearUpper = shear[2];
+  const std::array<Real,2> & shearLower = shear[1];
+  const std::array<Real,2> & norFront = s.nor[0];
+  const std::array<Real,2> & norUpper = s.nor[1];
+  const std::array<Real,2> & norLower = s.nor[2];
+  const std::array<Real,2> & tanFront = s.tan[0];
+  const std::array<Real,2> & tanUpper = s.tan[1];
+  const std::array<Real,2> & tanLower = s.tan[2];
 
   // project three stresses to normal and tangent directions
   const double shearFront_n = shearFront[0]*norFront[0]+shearFront[1]*norFront[1];
@@ -488,99 +593,86 @@ std::vector<Real> StefanFish::state3D() const
 // function that finds block id of block containing pos (x,y)
 ssize_t StefanFish::holdingBlockID(const std::array<Real,2> pos) const
 {
-  const std::vector<cubism::BlockInfo>& velInfo = sim.vel->getBlocksInfo();
-  for(size_t i=0; i<velInfo.size(); ++i)
-  {
-    // compute lower left and top right corners of block (+- 0.5 h because pos returns cell centers)
-    std::array<Real,2> MIN = velInfo[i].pos<Real>(0                   , 0                   );
-    std::array<Real,2> MAX = velInfo[i].pos<Real>(VectorBlock::sizeX-1, VectorBlock::sizeY-1);
-    MIN[0] -= 0.5 * velInfo[i].h;
-    MIN[1] -= 0.5 * velInfo[i].h;
-    MAX[0] += 0.5 * velInfo[i].h;
-    MAX[1] += 0.5 * velInfo[i].h;
-
-    // check whether point is inside block
-    if( pos[0] >= MIN[0] && pos[1] >= MIN[1] && pos[0] <= MAX[0] && pos[1] <= MAX[1] )
-    {
-      return i;
-    }
-  }
-  return -1; // rank does not contain point
+  return sim.holdingBlockID(pos); // -1 if rank does not contain point
 };
 
 // returns shear at given surface location
 std::array<Real, 2> StefanFish::getShear(const std::array<Real,2> pSurf) const
 {
-  const std::vector<cubism::BlockInfo>& velInfo = sim.vel->getBlocksInfo(); 
+  return getShear({this}, {pSurf})[0];
+}
 
-  Real myF[2] = {0,0};
-  
-  // Get blockId of block that contains point pSurf.
-  ssize_t blockIdSurf = holdingBlockID(pSurf);
-  char error = false;
-  if( blockIdSurf >= 0 )
-  {
-    const auto & skinBinfo = velInfo[blockIdSurf];
+std::vector<std::array<Real,2>> StefanFish::getShear(const std::vector<const StefanFish*>& owner, const std::vector<std::array<Real,2>>& pSurf)
+{
+  const size_t P = pSurf.size();
+  std::vector<std::array<Real,2>> shear(P, std::array<Real,2>{{0,0}});
+  if (P == 0) return shear;
+  SimulationData & sim = owner[0]->sim;
+
+  // each rank evaluates the points in its blocks, one reduction for all
+  SensorGather sensors(sim);
+  std::vector<size_t> offset(P);
+  for(size_t p=0; p<P; ++p)
+    offset[p] = sensors.addPoint(pSurf[p], 2, [&owner, p](ssize_t blockID, const std::array<Real,2>& pos, Real* F) {
+      return owner[p]->shearInBlock(blockID, pos, F);
+    });
+  sensors.gather();
 
-    // check whether obstacle block exists
-    if(obstacleBlocks[blockIdSurf] == nullptr )
-    {
-      printf("[CUP2D, rank %u] velInfo[%lu] contains point (%f,%f), but obstacleBlocks[%lu] is a nullptr! obstacleBlocks.size()=%lu\n", sim.rank, blockIdSurf, (double)pSurf[0], (double)pSurf[1], blockIdSurf, obstacleBlocks.size());
-      const std::vector<cubism::BlockInfo>& chiInfo = sim.chi->getBlocksInfo();
-      const auto& chiBlock = chiInfo[blockIdSurf];
-      ScalarBlock & __restrict__ CHI = *(ScalarBlock*) chiBlock.ptrBlock;
-      for( size_t i = 0; i<ScalarBlock::sizeX; i++) 
-      for( size_t j = 0; j<ScalarBlock::sizeY; j++)
-      {
-        const auto pos = chiBlock.pos<Real>(i, j);
-        printf("i,j=%ld,%ld: pos=(%f,%f) with chi=%f\n", i, j, (double)pos[0], (double)pos[1], (double)CHI(i,j).s);
-      }
-      fflush(0);
-      error = true;
-    }
-    else
+  // return shear
+  for(size_t p=0; p<P; ++p)
+    shear[p] = {sensors.values(offset[p])[0], sensors.values(offset[p])[1]};
+  return shear;
+}
+
+// shear of the surface point of this fish in block blockIdSurf that is
+// closest to pSurf, false if the block has no obstacle block
+bool StefanFish::shearInBlock(const ssize_t blockIdSurf, const std::array<Real,2> pSurf, Real myF[2]) const
+{
+  const std::vector<cubism::BlockInfo>& velInfo = sim.vel->getBlocksInfo();
+  const auto & skinBinfo = velInfo[blockIdSurf];
+
+  // check whether obstacle block exists
+  if(obstacleBlocks[blockIdSurf] == nullptr )
+  {
+    printf("[CUP2D, rank %u] velInfo[%lu] contains point (%f,%f), but obstacleBlocks[%lu] is a nullptr! obstacleBlocks.size()=%lu\n", sim.rank, blockIdSurf, (double)pSurf[0], (double)pSurf[1], blockIdSurf, obstacleBlocks.size());
+    const std::vector<cubism::BlockInfo>& chiInfo = sim.chi->getBlocksInfo();
+    const auto& chiBlock = chiInfo[blockIdSurf];
+    ScalarBlock & __restrict__ CHI = *(ScalarBlock*) chiBlock.ptrBlock;
+    for( size_t i = 0; i<ScalarBlock::sizeX; i++) 
+    for( size_t j = 0; j<ScalarBlock::sizeY; j++)
     {
-      Real dmin = 1e10;
-      ObstacleBlock * const O = obstacleBlocks[blockIdSurf];
-      for(size_t k = 0; k < O->n_surfPoints; ++k)
-      {
-        const int ix = O->surface[k]->ix;
-        const int iy = O->surface[k]->iy;
-        const std::array<Real,2> p = skinBinfo.pos<Real>(ix, iy);
-        const Real d = (p[0]-pSurf[0])*(p[0]-pSurf[0])+(p[1]-pSurf[1])*(p[1]-pSurf[1]);
-        if (d < dmin)
-        {
-          dmin = d;
-          myF[0] = O->fXv_s[k];
-          myF[1] = O->fYv_s[k];
-        }
-      }
+      const auto pos = chiBlock.pos<Real>(i, j);
+      printf("i,j=%ld,%ld: pos=(%f,%f) with chi=%f\n", i, j, (double)pos[0], (double)pos[1], (double)CHI(i,j).s);
     }
+    fflush(0);
+    return false;
   }
-  MPI_Allreduce(MPI_IN_PLACE, myF, 2, MPI_Real, MPI_SUM, sim.chi->getWorldComm());
 
-  // DEBUG purposes
-  #if 1
-    MPI_Allreduce(MPI_IN_PLACE, &blockIdSurf, 1, MPI_INT64_T, MPI_MAX, sim.chi->getWorldComm());
-    if( sim.rank == 0 && blockIdSurf == -1 )
-    {
-      printf("ABORT: coordinate (%g,%g) could not be associated to ANY obstacle block\n", (double)pSurf[0], (double)pSurf[1]);
-      fflush(0);
-      abort();
-    }
-    MPI_Allreduce(MPI_IN_PLACE, &error, 1, MPI_CHAR, MPI_LOR, sim.chi->getWorldComm());
-    if( error )
+  Real dmin = 1e10;
+  ObstacleBlock * const O = obstacleBlocks[blockIdSurf];
+  for(size_t k = 0; k < O->n_surfPoints; ++k)
+  {
+    const int ix = O->surface[k]->ix;
+    const int iy = O->surface[k]->iy;
+    const std::array<Real,2> p = skinBinfo.pos<Real>(ix, iy);
+    const Real d = (p[0]-pSurf[0])*(p[0]-pSurf[0])+(p[1]-pSurf[1])*(p[1]-pSurf[1]);
+    if (d < dmin)
     {
-      sim.dumpAll("failed");
-      abort();
+      dmin = d;
+      myF[0] = O->fXv_s[k];
+      myF[1] = O->fYv_s[k];
     }
-  #endif
-
-  // return shear
-  return std::array<Real, 2>{{myF[0],myF[1]}};
-};
+  }
+  return true;
+}
 
 void CurvatureFish::computeMidline(const Real t, const Real dt)
+{
+  updateGait(t, dt);
+  solveMidline(t, dt);
+}
+
+void CurvatureFish::updateGait(const Real t, const Real dt)
 {
   periodScheduler.transition(t,transition_start,transition_start+transition_duration,current_period,next_period);
   periodScheduler.gimmeValues(t,periodPIDval,periodPIDdif);
@@ -590,18 +682,11 @@ void CurvatureFish::computeMidline(const Real t, const Real dt)
 	  time0 = t;
   }
 
-  // define interpolation points on midline
-  const std::array<Real ,6> curvaturePoints = { (Real)0, (Real).15*length,
-    (Real).4*length, (Real).65*length, (Real).9*length, length
-  };
   // define values of curvature at interpolation points
   const std::array<Real ,6> curvatureValues = {
       (Real)0.82014/length, (Real)1.46515/length, (Real)2.57136/length,
       (Real)3.75425/length, (Real)5.09147/length, (Real)5.70449/length
   };
-  // define interpolation points for RL action
-  const std::array<Real,7> bendPoints = {(Real)-.5, (Real)-.25, (Real)0,
-    (Real).25, (Real).5, (Real).75, (Real)1};
 
   // transition curvature from 0 to target values
   #if 1 // ramp-up over Tperiod
@@ -619,10 +704,17 @@ void CurvatureFish::computeMidline(const Real t, const Real dt)
   #else // no rampup for debug
   curvatureScheduler.transition(t,0,Tperiod,curvatureValues,curvatureValues);
   #endif
+}
 
-  // write curvature values
-  curvatureScheduler.gimmeValues(t, curvaturePoints, Nm, rS, rC, vC);
-  rlBendingScheduler.gimmeValues(t, periodPIDval, length, bendPoints, Nm, rS, rB, vB);
+void CurvatureFish::solveMidline(const Real t, const Real dt)
+{
+  // define interpolation points on midline
+  const std::array<Real ,6> curvaturePoints = { (Real)0, (Real).15*length,
+    (Real).4*length, (Real).65*length, (Real).9*length, length
+  };
+  // define interpolation points for RL action
+  const std::array<Real,7> bendPoints = {(Real)-.5, (Real)-.25, (Real)0,
+    (Real).25, (Real).5, (Real).75, (Real)1};
 
   // next term takes into account the derivative of periodPIDval in darg:
   const Real diffT = 1 - (t-time0)*periodPIDdif/periodPIDval;
@@ -630,6 +722,42 @@ void CurvatureFish::computeMidline(const Real t, const Real dt)
   const Real darg = 2*M_PI/periodPIDval * diffT;
   const Real arg0 = 2*M_PI*((t-time0)/periodPIDval +timeshift) +M_PI*phaseShift;
 
+  if (bCacheGait && t > curvatureScheduler.t1)
+  {
+    // ramp-up is over: rC is constant and vC is zero
+    if (not gaitCached)
+    {
+      curvatureScheduler.gimmeValues(t, curvaturePoints, Nm, rS, rC, vC);
+      for(int i=0; i<Nm; ++i) {
+        const Real a = 2*M_PI*rS[i]/length;
+        gaitSin[i] =  amplitudeFactor*rC[i]*std::cos(a);
+        gaitCos[i] = -amplitudeFactor*rC[i]*std::sin(a);
+      }
+      gaitCached = true;
+    }
+    bool bending = false;
+    for(int j=0; j<7; ++j) bending = bending || rlBendingScheduler.parameters_t0[j] != 0;
+    if (bending)
+      rlBendingScheduler.gimmeValues(t, periodPIDval, length, bendPoints, Nm, rS, rB, vB);
+
+    const Real sin0 = std::sin(arg0), cos0 = std::cos(arg0);
+    #pragma omp parallel for schedule(static)
+    for(int i=0; i<Nm; ++i) {
+      const Real B  = bending ? rB[i] : 0;
+      const Real dB = bending ? vB[i] : 0;
+      rK[i] = sin0*gaitSin[i] + cos0*gaitCos[i] + amplitudeFactor*rC[i]*(B +curv_PID_fac);
+      vK[i] = (cos0*gaitSin[i] - sin0*gaitCos[i])*darg + amplitudeFactor*rC[i]*(dB +curv_PID_dif);
+    }
+
+    // solve frenet to compute midline parameters
+    IF2D_Frenet2D::solve(Nm, rS, rK,vK, rX,rY, vX,vY, norX,norY, vNorX,vNorY);
+    return;
+  }
+
+  // write curvature values
+  curvatureScheduler.gimmeValues(t, curvaturePoints, Nm, rS, rC, vC);
+  rlBendingScheduler.gimmeValues(t, periodPIDval, length, bendPoints, Nm, rS, rB, vB);
+
   #pragma omp parallel for schedule(static)
   for(int i=0; i<Nm; ++i) {
     const Real arg = arg0 - 2*M_PI*rS[i]/length;
@@ -659,32 +787,9 @@ void CurvatureFish::computeMidline(const Real t, const Real dt)
 /***** Old Helpers (here for backward compatibility) ******/
 
 // function that finds block id of block containing pos (x,y)
-ssize_t StefanFish::holdingBlockID(const std::array<Real,2> pos, const std::vector<cubism::BlockInfo>& velInfo) const
+ssize_t StefanFish::holdingBlockID(const std::array<Real,2> pos, const std::vector<cubism::BlockInfo>& /* velInfo: same block order */) const
 {
-  for(size_t i=0; i<velInfo.size(); ++i)
-  {
-    // get gridspacing in block
-    const Real h = velInfo[i].h;
-
-    // compute lower left corner of block
-    std::array<Real,2> MIN = velInfo[i].pos<Real>(0, 0);
-    for(int j=0; j<2; ++j)
-      MIN[j] -= 0.5 * h; // pos returns cell centers
-
-    // compute top right corner of block
-    std::array<Real,2> MAX = velInfo[i].pos<Real>(VectorBlock::sizeX-1, VectorBlock::sizeY-1);
-    for(int j=0; j<2; ++j)
-      MAX[j] += 0.5 * h; // pos returns cell centers
-
-    // check whether point is inside block
-    if( pos[0] >= MIN[0] && pos[1] >= MIN[1] && pos[0] <= MAX[0] && pos[1] <= MAX[1] )
-    {
-      // point lies inside this block
-      return i;
-    }
-  }
-  // rank does not contain point
-  return -1;
+  return sim.holdingBlockID(pos);
 };
 
 // function that gives indice of point in block
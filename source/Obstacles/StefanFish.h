@@ -26,9 +26,27 @@ class StefanFish: public Fish
   std::vector<Real> state( const std::vector<double>& origin ) const;
   std::vector<Real> state3D( ) const;
 
+  // States of many fish at once (collective), equal to calling state() for
+  // each one: the sensors of all fish are located with a single pass over the
+  // grid and reduced together.
+  static std::vector<std::vector<Real>> states(const std::vector<const StefanFish*>& fish, const std::vector<double>& origin);
+
   // Helpers for state function
   ssize_t holdingBlockID(const std::array<Real,2> pos) const;
   std::array<Real, 2> getShear(const std::array<Real,2> pSurf) const;
+  // shear at the surface points pSurf[i] of the fish owner[i] (collective)
+  static std::vector<std::array<Real,2>> getShear(const std::vector<const StefanFish*>& owner, const std::vector<std::array<Real,2>>& pSurf);
+
+  // shear sensors: front, upper and lower side of the head
+  struct Sensors
+  {
+    std::array<std::array<Real,2>,3> loc; // locations
+    std::array<std::array<Real,2>,3> nor; // unit normals
+    std::array<std::array<Real,2>,3> tan; // unit tangents, pointing towards the tail
+  };
+  Sensors sensors() const;
+  std::vector<Real> state(const std::vector<double>& origin, const Sensors& s, const std::array<std::array<Real,2>,3>& shear) const;
+  bool shearInBlock(const ssize_t blockID, const std::array<Real,2> pSurf, Real myF[2]) const;
 
   // Old Helpers (here for backward compatibility)
   ssize_t holdingBlockID(const std::array<Real,2> pos, const std::vector<cubism::BlockInfo>& velInfo) const;
@@ -38,6 +56,12 @@ class StefanFish: public Fish
   // Helpers to restart simulation
   virtual void saveRestart( FILE * f ) override;
   virtual void loadRestart( FILE * f ) override;
+  virtual std::string snapshot() override;
+  virtual void restore( const std::string & state ) override;
+  void saveSchedulers( std::ostream & out ) const;
+  void loadSchedulers( std::istream & in );
+  void saveControllers( FILE * f ) const;
+  void loadControllers( FILE * f );
 };
 
 class CurvatureFish : public FishData
@@ -78,6 +102,12 @@ class CurvatureFish : public FishData
   Real transition_start  = 0.0;
   Real transition_duration = 0.1*Tperiod;
 
+  // Once the curvature ramp-up is over, rC is constant and
+  //   A*rC*sin(arg0 - 2*pi*s/L) = sin(arg0)*gaitSin(s) + cos(arg0)*gaitCos(s),
+  // so the phase dependence of the curvature reduces to two profiles that are
+  // computed once. The RL bending wave is added only while it is non-zero.
+  bool bCacheGait = false;
+
  protected:
   Real * const rK;
   Real * const vK;
@@ -85,12 +115,16 @@ class CurvatureFish : public FishData
   Real * const vC;
   Real * const rB;
   Real * const vB;
+  Real * const gaitSin;
+  Real * const gaitCos;
+  bool gaitCached = false;
 
  public:
 
   CurvatureFish(Real L, Real T, Real phi, Real _h, Real _A)
   : FishData(L, _h), amplitudeFactor(_A),  phaseShift(phi),  Tperiod(T), rK(_alloc(Nm)), vK(_alloc(Nm)),
-    rC(_alloc(Nm)), vC(_alloc(Nm)), rB(_alloc(Nm)), vB(_alloc(Nm)) 
+    rC(_alloc(Nm)), vC(_alloc(Nm)), rB(_alloc(Nm)), vB(_alloc(Nm)),
+    gaitSin(_alloc(Nm)), gaitCos(_alloc(Nm))
     {
       _computeWidth();
       writeMidline2File(0, "initialCheck");
@@ -112,9 +146,14 @@ class CurvatureFish : public FishData
     timeshift = 0;
     lastTime = 0;
     lastAvel = 0;
+    current_period = Tperiod;
+    next_period = Tperiod;
+    transition_start = 0;
+    transition_duration = 0.1*Tperiod;
     curvatureScheduler.resetAll();
     periodScheduler.resetAll();
     rlBendingScheduler.resetAll();
+    gaitCached = false;
 
     FishData::resetAll();
   }
@@ -170,10 +209,13 @@ class CurvatureFish : public FishData
 
   ~CurvatureFish() override {
     _dealloc(rK); _dealloc(vK); _dealloc(rC); _dealloc(vC);
-    _dealloc(rB); _dealloc(vB);
+    _dealloc(rB); _dealloc(vB); _dealloc(gaitSin); _dealloc(gaitCos);
   }
 
   void computeMidline(const Real time, const Real dt) override;
+  bool distributeMidline() const override { return true; }
+  void updateGait(const Real time, const Real dt) override;
+  void solveMidline(const Real time, const Real dt) override;
   Real _width(const Real s, const Real L) override
   {
     const Real sb=.04*length, st=.95*length, wt=.01*length, wh=.04*length;
@@ -18,6 +18,7 @@ class TeardropData : public FishData
   : FishData(L, _h), tRatio(_tRatio) { _computeWidth(); }
 
   void computeMidline(const Real time, const Real dt) override;
+  bool distributeMidline() const override { return true; }
   Real _width(const Real s, const Real L) override
   {
     // Compute radius of half-circle using given t-ratio
@@ -1,6 +1,7 @@
 #include "Windmill.h"
 #include "ShapeLibrary.h"
 #include "../Utils/BufferedLogger.h"
+#include "../Utils/SensorGather.h"
 #include <cmath>
 
 using namespace cubism;
@@ -227,9 +228,12 @@ std::vector<std::vector<Real>> Windmill::vel_profile()
   // each one of the 16 intervals has a height of 0.35/16 = 0.021875
   // we average the velocity in each of the 32 intervals
 
-  std::vector<Real> vel_x_avg(numberRegions, 0.0);
-  std::vector<Real> vel_y_avg(numberRegions, 0.0);
-  std::vector<Real> region_area(numberRegions, 0.0);
+  // the three sums are reduced together
+  SensorGather sensors(sim);
+  const size_t offset = sensors.addSum(3*numberRegions);
+  Real * const vel_x_avg   = sensors.values(offset);
+  Real * const vel_y_avg   = vel_x_avg + numberRegions;
+  Real * const region_area = vel_y_avg + numberRegions;
 
   Real height = 0.021875;
 
@@ -264,12 +268,9 @@ std::vector<std::vector<Real>> Windmill::vel_profile()
   }
 
 
-  // collects the sum over all the components of the velocity profile into the vector vel_avg
-  MPI_Allreduce(MPI_IN_PLACE, &vel_x_avg[0], numberRegions, MPI_Real, MPI_SUM, sim.comm);
-  MPI_Allreduce(MPI_IN_PLACE, &vel_y_avg[0], numberRegions, MPI_Real, MPI_SUM, sim.comm);
-
-  // collects the sum over all the region areas in order to perform the averaging correctly
-  MPI_Allreduce(MPI_IN_PLACE, &region_area[0], numberRegions, MPI_Real, MPI_SUM, sim.comm);
+  // collects the sums of the velocity components and of the region areas
+  // (needed to perform the averaging correctly) over all ranks
+  sensors.gather();
 
 
   // 2 x numberRegions vector
@@ -8,6 +8,25 @@
 
 #include "SimulationData.h"
 
+// Data an operator may modify. Simulation::advance uses the write sets to
+// invalidate cached by-products of the velocity (see velVersion).
+// SHAPES covers the state of the obstacles and the frame velocity uinf,
+// MESH the block structure of the grids.
+enum OperatorData : unsigned
+{
+  OP_VEL    = 1u << 0,
+  OP_CHI    = 1u << 1,
+  OP_PRES   = 1u << 2,
+  OP_POLD   = 1u << 3,
+  OP_VOLD   = 1u << 4,
+  OP_TMP    = 1u << 5,
+  OP_TMPV   = 1u << 6,
+  OP_CS     = 1u << 7,
+  OP_SHAPES = 1u << 8,
+  OP_MESH   = 1u << 9,
+  OP_ALL    = (1u << 10) - 1
+};
+
 class Operator
 {
 public:
@@ -16,4 +35,7 @@ public:
   virtual ~Operator() {}
   virtual void operator()(const Real dt) = 0;
   virtual std::string getName() = 0;
+
+  // Write set (OperatorData bitmask), conservative by default.
+  virtual unsigned writes() const { return OP_ALL; }
 };
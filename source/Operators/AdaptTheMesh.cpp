@@ -118,5 +118,36 @@ void AdaptTheMesh::adapt()
   if( sim.smagorinskyCoeff != 0 )
     Cs_amr->Adapt(sim.time, false, true);
 
+  sim.invalidateH();
+  sim.invalidateVel();
+
   sim.stopProfiler();
 }
+
+void AdaptTheMesh::adaptTagged()
+{
+  const std::vector<cubism::BlockInfo>& tmpInfo = sim.tmp->getBlocksInfo();
+
+  tmp_amr ->TagLike(tmpInfo);
+  chi_amr ->TagLike(tmpInfo);
+  pres_amr->TagLike(tmpInfo);
+  pold_amr->TagLike(tmpInfo);
+  vel_amr ->TagLike(tmpInfo);
+  vOld_amr->TagLike(tmpInfo);
+  tmpV_amr->TagLike(tmpInfo);
+  if( sim.smagorinskyCoeff != 0 )
+    Cs_amr->TagLike(tmpInfo);
+
+  tmp_amr ->Adapt(sim.time, false, true);
+  chi_amr ->Adapt(sim.time, false, true);
+  vel_amr ->Adapt(sim.time, false, true);
+  vOld_amr->Adapt(sim.time, false, true);
+  pres_amr->Adapt(sim.time, false, true);
+  pold_amr->Adapt(sim.time, false, true);
+  tmpV_amr->Adapt(sim.time, false, true);
+  if( sim.smagorinskyCoeff != 0 )
+    Cs_amr->Adapt(sim.time, false, true);
+
+  sim.invalidateH();
+  sim.invalidateVel();
+}
@@ -49,6 +49,10 @@ class AdaptTheMesh : public Operator
   void operator() (const Real dt) override;
   void adapt();
 
+  // refines/compresses all grids according to the states set by the caller
+  // in the infos of sim.tmp, without interpolating the field values
+  void adaptTagged();
+
   std::string getName() override
   {
     return "AdaptTheMesh";
@@ -17,195 +17,235 @@
 
 using UDEFMAT = Real[VectorBlock::sizeY][VectorBlock::sizeX][2];
 
-struct KernelComputeForces
+void KernelComputeForces::operator()(VectorLab & lab, ScalarLab & chi, const cubism::BlockInfo& info, const cubism::BlockInfo& info2) const
 {
-  const int big   = 5;
-  const int small = -4;
-  KernelComputeForces(const SimulationData & s) : sim(s) {}
-  const SimulationData & sim;
-  cubism::StencilInfo stencil {small, small, 0, big, big, 1, true, {0,1}};
-  cubism::StencilInfo stencil2{small, small, 0, big, big, 1, true, {0}};
-
-  const int bigg = ScalarBlock::sizeX + big-1;
-  const int stencil_start[3] = {small,small,small}, stencil_end[3] = {big,big,big};
-  const Real c0 = -137./60.;
-  const Real c1 =    5.    ;
-  const Real c2 = -  5.    ;
-  const Real c3 =   10./ 3.;
-  const Real c4 = -  5./ 4.;
-  const Real c5 =    1./ 5.;
-
-  inline bool inrange(const int i) const
-  {
-    return (i >= small && i < bigg);
-  }
-
+  VectorLab & V = lab;
+  ScalarBlock & __restrict__ P = *(ScalarBlock*) presInfo[info.blockID].ptrBlock;
 
-  const std::vector<cubism::BlockInfo>& presInfo = sim.pres->getBlocksInfo();
-
-  void operator()(VectorLab & lab, ScalarLab & chi, const cubism::BlockInfo& info, const cubism::BlockInfo& info2) const
+  //const int big   = ScalarBlock::sizeX + 4;
+  //const int small = -4;
+  for(const auto& _shape : sim.shapes)
   {
-    VectorLab & V = lab;
-    ScalarBlock & __restrict__ P = *(ScalarBlock*) presInfo[info.blockID].ptrBlock;
-
-    //const int big   = ScalarBlock::sizeX + 4;
-    //const int small = -4;
-    for(const auto& _shape : sim.shapes)
+    const Shape * const shape = _shape.get();
+    const std::vector<ObstacleBlock*> & OBLOCK = shape->obstacleBlocks;
+    const Real Cx = shape->centerOfMass[0], Cy = shape->centerOfMass[1];
+    const Real vel_norm = std::sqrt(shape->u*shape->u + shape->v*shape->v);
+    const Real vel_unit[2] = {
+      vel_norm>0? (Real) shape->u / vel_norm : (Real)0,
+      vel_norm>0? (Real) shape->v / vel_norm : (Real)0
+    };
+ 
+    const Real NUoH = sim.nu / info.h; // 2 nu / 2 h
+    ObstacleBlock * const O = OBLOCK[info.blockID];
+    if (O == nullptr || not shape->needsForces()) continue;
+    assert(O->filled);
+    for(size_t k = 0; k < O->n_surfPoints; ++k)
     {
-      const Shape * const shape = _shape.get();
-      const std::vector<ObstacleBlock*> & OBLOCK = shape->obstacleBlocks;
-      const Real Cx = shape->centerOfMass[0], Cy = shape->centerOfMass[1];
-      const Real vel_norm = std::sqrt(shape->u*shape->u + shape->v*shape->v);
-      const Real vel_unit[2] = {
-        vel_norm>0? (Real) shape->u / vel_norm : (Real)0,
-        vel_norm>0? (Real) shape->v / vel_norm : (Real)0
-      };
-   
-      const Real NUoH = sim.nu / info.h; // 2 nu / 2 h
-      ObstacleBlock * const O = OBLOCK[info.blockID];
-      if (O == nullptr) continue;
-      assert(O->filled);
-      for(size_t k = 0; k < O->n_surfPoints; ++k)
+      const int ix = O->surface[k]->ix, iy = O->surface[k]->iy;
+      const std::array<Real,2> p = info.pos<Real>(ix, iy);
+
+      const Real normX = O->surface[k]->dchidx; //*h^3 (multiplied in dchidx)
+      const Real normY = O->surface[k]->dchidy; //*h^3 (multiplied in dchidy)
+      const Real norm = 1.0/std::sqrt(normX*normX+normY*normY);
+      const Real dx = normX*norm;
+      const Real dy = normY*norm;
+      //shear stresses
+      //"lifted" surface: derivatives make no sense when the values used are in the object, 
+      // so we take one-sided stencils with values outside of the object
+      //Real D11 = 0.0;
+      //Real D22 = 0.0;
+      //Real D12 = 0.0;
+      Real DuDx;
+      Real DuDy;
+      Real DvDx;
+      Real DvDy;
       {
-        const int ix = O->surface[k]->ix, iy = O->surface[k]->iy;
-        const std::array<Real,2> p = info.pos<Real>(ix, iy);
-
-        const Real normX = O->surface[k]->dchidx; //*h^3 (multiplied in dchidx)
-        const Real normY = O->surface[k]->dchidy; //*h^3 (multiplied in dchidy)
-        const Real norm = 1.0/std::sqrt(normX*normX+normY*normY);
-        const Real dx = normX*norm;
-        const Real dy = normY*norm;
-        //shear stresses
-        //"lifted" surface: derivatives make no sense when the values used are in the object, 
-        // so we take one-sided stencils with values outside of the object
-        //Real D11 = 0.0;
-        //Real D22 = 0.0;
-        //Real D12 = 0.0;
-        Real DuDx;
-        Real DuDy;
-        Real DvDx;
-        Real DvDy;
+        //The integers x and y will be the coordinates of the point on the lifted surface.
+        //To find them, we move along the normal vector to the surface, until we find a point
+        //outside of the object (where chi = 0).
+        int x = ix;
+        int y = iy;
+        for (int kk = 0 ; kk < 5 ; kk++) //5 is arbitrary
         {
-          //The integers x and y will be the coordinates of the point on the lifted surface.
-          //To find them, we move along the normal vector to the surface, until we find a point
-          //outside of the object (where chi = 0).
-          int x = ix;
-          int y = iy;
-          for (int kk = 0 ; kk < 5 ; kk++) //5 is arbitrary
-          {
-            const int dxi = round(kk*dx);
-            const int dyi = round(kk*dy);
-            if (ix + dxi + 1 >= ScalarBlock::sizeX + big-1 || ix + dxi -1 < small) continue;
-            if (iy + dyi + 1 >= ScalarBlock::sizeY + big-1 || iy + dyi -1 < small) continue;
-            x  = ix + dxi; 
-            y  = iy + dyi;
-            if (chi(x,y).s < 0.01 ) break;
-          }
-
-
-          //Now that we found the (x,y) of the point, we compute grad(u) there.
-          //grad(u) is computed with biased stencils. If available, larger stencils are used.
-          //Then, we compute higher order derivatives that are used to form a Taylor expansion
-          //around (x,y). Finally, this expansion is used to extrapolate grad(u) to (ix,iy) of 
-          //the actual solid surface. 
-
-          const auto & l = lab;
-          const int sx = normX > 0 ? +1:-1;
-          const int sy = normY > 0 ? +1:-1;
-
-          VectorElement dveldx;
-          if      (inrange(x+5*sx)) dveldx = sx*(  c0*l(x,y)+ c1*l(x+sx,y)+ c2*l(x+2*sx,y)+c3*l(x+3*sx,y)+c4*l(x+4*sx,y)+c5*l(x+5*sx,y));
-          else if (inrange(x+2*sx)) dveldx = sx*(-1.5*l(x,y)+2.0*l(x+sx,y)-0.5*l(x+2*sx,y));
-          else                      dveldx = sx*(l(x+sx,y)-l(x,y));
-          VectorElement dveldy;
-          if      (inrange(y+5*sy)) dveldy = sy*(  c0*l(x,y)+ c1*l(x,y+sy)+ c2*l(x,y+2*sy)+c3*l(x,y+3*sy)+c4*l(x,y+4*sy)+c5*l(x,y+5*sy));
-          else if (inrange(y+2*sy)) dveldy = sy*(-1.5*l(x,y)+2.0*l(x,y+sy)-0.5*l(x,y+2*sy));
-          else                      dveldy = sx*(l(x,y+sy)-l(x,y));
-
-          const VectorElement dveldx2 = l(x-1,y)-2.0*l(x,y)+ l(x+1,y);
-          const VectorElement dveldy2 = l(x,y-1)-2.0*l(x,y)+ l(x,y+1);
-
-          VectorElement dveldxdy;
-          if (inrange(x+2*sx) && inrange(y+2*sy)) dveldxdy = sx*sy*(-0.5*( -1.5*l(x+2*sx,y     )+2*l(x+2*sx,y+  sy)  -0.5*l(x+2*sx,y+2*sy)       ) + 2*(-1.5*l(x+sx,y)+2*l(x+sx,y+sy)-0.5*l(x+sx,y+2*sy)) -1.5*(-1.5*l(x,y)+2*l(x,y+sy)-0.5*l(x,y+2*sy)));
-          else                                    dveldxdy = sx*sy*(            l(x+  sx,y+  sy)-  l(x+  sx,y     )) -   (l(x     ,y  +sy)-l(x,y));
-
-          DuDx = dveldx.u[0] + dveldx2.u[0]*(ix-x) + dveldxdy.u[0]*(iy-y);
-          DvDx = dveldx.u[1] + dveldx2.u[1]*(ix-x) + dveldxdy.u[1]*(iy-y);
-          DuDy = dveldy.u[0] + dveldy2.u[0]*(iy-y) + dveldxdy.u[0]*(ix-x);
-          DvDy = dveldy.u[1] + dveldy2.u[1]*(iy-y) + dveldxdy.u[1]*(ix-x);
-        }//shear stress computation ends here
-
-        //normals computed with Towers 2009
-        // Actually using the volume integral, since (/iint -P /hat{n} dS) =
-        // (/iiint - /nabla P dV). Also, P*/nabla /Chi = /nabla P
-        // penalty-accel and surf-force match up if resolution is high enough
-        //const Real fXV = D11*normX + D12*normY, fXP = - P(ix,iy).s * normX;
-        //const Real fYV = D12*normX + D22*normY, fYP = - P(ix,iy).s * normY;
-        const Real fXV = NUoH*DuDx*normX + NUoH*DuDy*normY, fXP = - P(ix,iy).s * normX;
-        const Real fYV = NUoH*DvDx*normX + NUoH*DvDy*normY, fYP = - P(ix,iy).s * normY;
-
-        const Real fXT = fXV + fXP, fYT = fYV + fYP;
-
-        //store:
-        O->x_s    [k] = p[0];
-        O->y_s    [k] = p[1];
-        O->p_s    [k] = P(ix,iy).s;
-        O->u_s    [k] = V(ix,iy).u[0];
-        O->v_s    [k] = V(ix,iy).u[1];
-        O->nx_s   [k] = dx;
-        O->ny_s   [k] = dy;
-        O->omega_s[k] = (DvDx - DuDy)/info.h;
-        O->uDef_s [k] = O->udef[iy][ix][0];
-        O->vDef_s [k] = O->udef[iy][ix][1];
-        O->fX_s   [k] = -P(ix,iy).s * dx + NUoH*DuDx*dx + NUoH*DuDy*dy;//scale by 1/h
-        O->fY_s   [k] = -P(ix,iy).s * dy + NUoH*DvDx*dx + NUoH*DvDy*dy;//scale by 1/h
-        O->fXv_s  [k] = NUoH*DuDx*dx + NUoH*DuDy*dy;//scale by 1/h
-        O->fYv_s  [k] = NUoH*DvDx*dx + NUoH*DvDy*dy;//scale by 1/h
-
-        //perimeter:
-        O->perimeter += std::sqrt(normX*normX + normY*normY);
-        O->circulation += normX * O->v_s[k] - normY * O->u_s[k];
-        //forces (total, visc, pressure):
-        O->forcex += fXT;
-        O->forcey += fYT;
-        O->forcex_V += fXV;
-        O->forcey_V += fYV;
-        O->forcex_P += fXP;
-        O->forcey_P += fYP;
-        //torque:
-        O->torque   += (p[0] - Cx) * fYT - (p[1] - Cy) * fXT;
-        O->torque_P += (p[0] - Cx) * fYP - (p[1] - Cy) * fXP;
-        O->torque_V += (p[0] - Cx) * fYV - (p[1] - Cy) * fXV;
-        //thrust, drag:
-        const Real forcePar = fXT * vel_unit[0] + fYT * vel_unit[1];
-        O->thrust += .5*(forcePar + std::fabs(forcePar));
-        O->drag   -= .5*(forcePar - std::fabs(forcePar));
-        const Real forcePerp = fXT * vel_unit[1] - fYT * vel_unit[0];
-        O->lift   += forcePerp;
-        //power output (and negative definite variant which ensures no elastic energy absorption)
-        // This is total power, for overcoming not only deformation, but also the oncoming velocity. Work done by fluid, not by the object (for that, just take -ve)
-        const Real powOut = fXT * O->u_s[k]    + fYT * O->v_s[k];
-        //deformation power output (and negative definite variant which ensures no elastic energy absorption)
-        const Real powDef = fXT * O->uDef_s[k] + fYT * O->vDef_s[k];
-        O->Pout        += powOut;
-        O->defPower    += powDef;
-        O->PoutBnd     += std::min((Real)0, powOut);
-        O->defPowerBnd += std::min((Real)0, powDef);
+          const int dxi = round(kk*dx);
+          const int dyi = round(kk*dy);
+          if (ix + dxi + 1 >= ScalarBlock::sizeX + big-1 || ix + dxi -1 < small) continue;
+          if (iy + dyi + 1 >= ScalarBlock::sizeY + big-1 || iy + dyi -1 < small) continue;
+          x  = ix + dxi; 
+          y  = iy + dyi;
+          if (chi(x,y).s < 0.01 ) break;
+        }
+
+
+        //Now that we found the (x,y) of the point, we compute grad(u) there.
+        //grad(u) is computed with biased stencils. If available, larger stencils are used.
+        //Then, we compute higher order derivatives that are used to form a Taylor expansion
+        //around (x,y). Finally, this expansion is used to extrapolate grad(u) to (ix,iy) of 
+        //the actual solid surface. 
+
+        const auto & l = lab;
+        const int sx = normX > 0 ? +1:-1;
+        const int sy = normY > 0 ? +1:-1;
+
+        VectorElement dveldx;
+        if      (inrange(x+5*sx)) dveldx = sx*(  c0*l(x,y)+ c1*l(x+sx,y)+ c2*l(x+2*sx,y)+c3*l(x+3*sx,y)+c4*l(x+4*sx,y)+c5*l(x+5*sx,y));
+        else if (inrange(x+2*sx)) dveldx = sx*(-1.5*l(x,y)+2.0*l(x+sx,y)-0.5*l(x+2*sx,y));
+        else                      dveldx = sx*(l(x+sx,y)-l(x,y));
+        VectorElement dveldy;
+        if      (inrange(y+5*sy)) dveldy = sy*(  c0*l(x,y)+ c1*l(x,y+sy)+ c2*l(x,y+2*sy)+c3*l(x,y+3*sy)+c4*l(x,y+4*sy)+c5*l(x,y+5*sy));
+        else if (inrange(y+2*sy)) dveldy = sy*(-1.5*l(x,y)+2.0*l(x,y+sy)-0.5*l(x,y+2*sy));
+        else                      dveldy = sx*(l(x,y+sy)-l(x,y));
+
+        const VectorElement dveldx2 = l(x-1,y)-2.0*l(x,y)+ l(x+1,y);
+        const VectorElement dveldy2 = l(x,y-1)-2.0*l(x,y)+ l(x,y+1);
+
+        VectorElement dveldxdy;
+        if (inrange(x+2*sx) && inrange(y+2*sy)) dveldxdy = sx*sy*(-0.5*( -1.5*l(x+2*sx,y     )+2*l(x+2*sx,y+  sy)  -0.5*l(x+2*sx,y+2*sy)       ) + 2*(-1.5*l(x+sx,y)+2*l(x+sx,y+sy)-0.5*l(x+sx,y+2*sy)) -1.5*(-1.5*l(x,y)+2*l(x,y+sy)-0.5*l(x,y+2*sy)));
+        else                                    dveldxdy = sx*sy*(            l(x+  sx,y+  sy)-  l(x+  sx,y     )) -   (l(x     ,y  +sy)-l(x,y));
+
+        DuDx = dveldx.u[0] + dveldx2.u[0]*(ix-x) + dveldxdy.u[0]*(iy-y);
+        DvDx = dveldx.u[1] + dveldx2.u[1]*(ix-x) + dveldxdy.u[1]*(iy-y);
+        DuDy = dveldy.u[0] + dveldy2.u[0]*(iy-y) + dveldxdy.u[0]*(ix-x);
+        DvDy = dveldy.u[1] + dveldy2.u[1]*(iy-y) + dveldxdy.u[1]*(ix-x);
+      }//shear stress computation ends here
+
+      //normals computed with Towers 2009
+      // Actually using the volume integral, since (/iint -P /hat{n} dS) =
+      // (/iiint - /nabla P dV). Also, P*/nabla /Chi = /nabla P
+      // penalty-accel and surf-force match up if resolution is high enough
+      //const Real fXV = D11*normX + D12*normY, fXP = - P(ix,iy).s * normX;
+      //const Real fYV = D12*normX + D22*normY, fYP = - P(ix,iy).s * normY;
+      const Real fXV = NUoH*DuDx*normX + NUoH*DuDy*normY, fXP = - P(ix,iy).s * normX;
+      const Real fYV = NUoH*DvDx*normX + NUoH*DvDy*normY, fYP = - P(ix,iy).s * normY;
+
+      const Real fXT = fXV + fXP, fYT = fYV + fYP;
+
+      //store:
+      O->x_s    [k] = p[0];
+      O->y_s    [k] = p[1];
+      O->p_s    [k] = P(ix,iy).s;
+      O->u_s    [k] = V(ix,iy).u[0];
+      O->v_s    [k] = V(ix,iy).u[1];
+      O->nx_s   [k] = dx;
+      O->ny_s   [k] = dy;
+      O->omega_s[k] = (DvDx - DuDy)/info.h;
+      O->uDef_s [k] = O->udef[iy][ix][0];
+      O->vDef_s [k] = O->udef[iy][ix][1];
+      O->fX_s   [k] = -P(ix,iy).s * dx + NUoH*DuDx*dx + NUoH*DuDy*dy;//scale by 1/h
+      O->fY_s   [k] = -P(ix,iy).s * dy + NUoH*DvDx*dx + NUoH*DvDy*dy;//scale by 1/h
+      O->fXv_s  [k] = NUoH*DuDx*dx + NUoH*DuDy*dy;//scale by 1/h
+      O->fYv_s  [k] = NUoH*DvDx*dx + NUoH*DvDy*dy;//scale by 1/h
+
+      //perimeter:
+      O->perimeter += std::sqrt(normX*normX + normY*normY);
+      O->circulation += normX * O->v_s[k] - normY * O->u_s[k];
+      //forces (total, visc, pressure):
+      O->forcex += fXT;
+      O->forcey += fYT;
+      O->forcex_V += fXV;
+      O->forcey_V += fYV;
+      O->forcex_P += fXP;
+      O->forcey_P += fYP;
+      //torque:
+      O->torque   += (p[0] - Cx) * fYT - (p[1] - Cy) * fXT;
+      O->torque_P += (p[0] - Cx) * fYP - (p[1] - Cy) * fXP;
+      O->torque_V += (p[0] - Cx) * fYV - (p[1] - Cy) * fXV;
+      //thrust, drag:
+      const Real forcePar = fXT * vel_unit[0] + fYT * vel_unit[1];
+      O->thrust += .5*(forcePar + std::fabs(forcePar));
+      O->drag   -= .5*(forcePar - std::fabs(forcePar));
+      const Real forcePerp = fXT * vel_unit[1] - fYT * vel_unit[0];
+      O->lift   += forcePerp;
+      //power output (and negative definite variant which ensures no elastic energy absorption)
+      // This is total power, for overcoming not only deformation, but also the oncoming velocity. Work done by fluid, not by the object (for that, just take -ve)
+      const Real powOut = fXT * O->u_s[k]    + fYT * O->v_s[k];
+      //deformation power output (and negative definite variant which ensures no elastic energy absorption)
+      const Real powDef = fXT * O->uDef_s[k] + fYT * O->vDef_s[k];
+      O->Pout        += powOut;
+      O->defPower    += powDef;
+      O->PoutBnd     += std::min((Real)0, powOut);
+      O->defPowerBnd += std::min((Real)0, powDef);
+    }
+    O->PoutNew = O->forcex*shape->u +  O->forcey*shape->v;
+  } 
+}
+
+// Two-grid compute driver that assembles labs only for the blocks marked in
+// `active`. The halo exchange is still the one of the synchronizers (which
+// send what the stencil needs for the whole grid); what is saved is the lab
+// construction with the wide stencil for all blocks without obstacles.
+template <typename Kernel, typename TGrid, typename LabMPI, typename TGrid2, typename LabMPI2>
+static void computeOnBlocks(const Kernel& kernel, TGrid& grid, TGrid2& grid2, const std::vector<bool>& active)
+{
+  cubism::SynchronizerMPI_AMR<Real,TGrid>& Synch = *grid.sync(kernel.stencil);
+  Kernel kernel2 = kernel;
+  kernel2.stencil = kernel.stencil2;
+  cubism::SynchronizerMPI_AMR<Real,TGrid2>& Synch2 = *grid2.sync(kernel2.stencil);
+
+  const cubism::StencilInfo& stencil  = Synch.getstencil();
+  const cubism::StencilInfo& stencil2 = Synch2.getstencil();
+
+  // interior blocks first (while halos are in flight), then the halo blocks
+  std::vector<cubism::BlockInfo*> avail0  = Synch .avail_inner();
+  std::vector<cubism::BlockInfo*> avail02 = Synch2.avail_inner();
+  for (int pass = 0; pass < 2; pass++)
+  {
+    if (pass == 1)
+    {
+      avail0  = Synch .avail_halo();
+      avail02 = Synch2.avail_halo();
+    }
+    std::vector<size_t> todo;
+    for (size_t i = 0; i < avail0.size(); i++)
+      if (active[avail0[i]->blockID]) todo.push_back(i);
+
+    #pragma omp parallel
+    {
+      LabMPI  lab;
+      LabMPI2 lab2;
+      lab .prepare(grid , stencil );
+      lab2.prepare(grid2, stencil2);
+      #pragma omp for schedule(dynamic,1)
+      for (size_t k = 0; k < todo.size(); k++)
+      {
+        const cubism::BlockInfo& I  = *avail0 [todo[k]];
+        const cubism::BlockInfo& I2 = *avail02[todo[k]];
+        lab .load(I , 0);
+        lab2.load(I2, 0);
+        kernel(lab, lab2, I, I2);
       }
-      O->PoutNew = O->forcex*shape->u +  O->forcey*shape->v;
-    } 
+    }
   }
-};
+}
 
 void ComputeForces::operator()(const Real dt)
 {
   sim.startProfiler("ComputeForces");
+  bool needed = false;
+  for (const auto& shape : sim.shapes) needed = needed || shape->needsForces();
+  if (not needed)
+  {
+    sim.stopProfiler();
+    return;
+  }
+
+  // only blocks that belong to the footprint of some obstacle need labs
+  const size_t Nblocks = presInfo.size();
+  std::vector<bool> active(Nblocks, false);
+  for (const auto& shape : sim.shapes)
+  {
+    if (not shape->needsForces()) continue;
+    const std::vector<ObstacleBlock*> & OBLOCK = shape->obstacleBlocks;
+    for (size_t i = 0; i < Nblocks; i++)
+      if (OBLOCK[presInfo[i].blockID] != nullptr) active[presInfo[i].blockID] = true;
+  }
+
   KernelComputeForces K(sim);
-  cubism::compute<KernelComputeForces,VectorGrid,VectorLab,ScalarGrid,ScalarLab>(K,*sim.vel,*sim.chi);
+  computeOnBlocks<KernelComputeForces,VectorGrid,VectorLab,ScalarGrid,ScalarLab>(K,*sim.vel,*sim.chi,active);
 
   // finalize partial sums
   for (const auto& shape : sim.shapes)
-    shape->computeForces();
+    if (shape->needsForces()) shape->computeForces();
   sim.stopProfiler();
 }
 
@@ -10,6 +10,35 @@
 
 class Shape;
 
+struct KernelComputeForces
+{
+  const int big   = 5;
+  const int small = -4;
+  KernelComputeForces(const SimulationData & s) : sim(s) {}
+  const SimulationData & sim;
+  cubism::StencilInfo stencil {small, small, 0, big, big, 1, true, {0,1}};
+  cubism::StencilInfo stencil2{small, small, 0, big, big, 1, true, {0}};
+
+  const int bigg = ScalarBlock::sizeX + big-1;
+  const int stencil_start[3] = {small,small,small}, stencil_end[3] = {big,big,big};
+  const Real c0 = -137./60.;
+  const Real c1 =    5.    ;
+  const Real c2 = -  5.    ;
+  const Real c3 =   10./ 3.;
+  const Real c4 = -  5./ 4.;
+  const Real c5 =    1./ 5.;
+
+  inline bool inrange(const int i) const
+  {
+    return (i >= small && i < bigg);
+  }
+
+
+  const std::vector<cubism::BlockInfo>& presInfo = sim.pres->getBlocksInfo();
+
+  void operator()(VectorLab & lab, ScalarLab & chi, const cubism::BlockInfo& info, const cubism::BlockInfo& info2) const;
+};
+
 class ComputeForces : public Operator
 {
   const std::vector<cubism::BlockInfo>& presInfo = sim.pres->getBlocksInfo();
@@ -24,4 +53,6 @@ public:
   {
     return "ComputeForces";
   }
+
+  unsigned writes() const override { return OP_SHAPES; }
 };
@@ -18,6 +18,8 @@ protected:
 
   void operator() (const Real dt) override;
 
+  unsigned writes() const override { return OP_VEL; }
+
   std::string getName() override
   {
     return "Forcing";
@@ -11,6 +11,7 @@ using namespace cubism;
 
 void IC::operator()(const Real dt)
 {
+  sim.invalidateVel();
   const std::vector<BlockInfo>& chiInfo  = sim.chi->getBlocksInfo();
   const std::vector<BlockInfo>& presInfo = sim.pres->getBlocksInfo();
   const std::vector<BlockInfo>& poldInfo = sim.pold->getBlocksInfo();
@@ -101,8 +102,32 @@ void IC::operator()(const Real dt)
   }
 }
 
+void taylorGreenIC::operator()(const Real dt)
+{
+  // clear all fields, then impose u = sin(kx)cos(ky), v = -cos(kx)sin(ky)
+  IC ic(sim);
+  ic(dt);
+  if( sim.bRestart ) return;
+
+  const Real kx = 2*M_PI/sim.extents[0];
+  const Real ky = 2*M_PI/sim.extents[1];
+  #pragma omp parallel for
+  for (size_t i=0; i < velInfo.size(); i++)
+  {
+    VectorBlock& VEL = *(VectorBlock*)  velInfo[i].ptrBlock;
+    for(int iy=0; iy<VectorBlock::sizeY; ++iy)
+    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
+    {
+      const std::array<Real,2> p = velInfo[i].pos<Real>(ix, iy);
+      VEL(ix,iy).u[0] =  std::sin(kx*p[0])*std::cos(ky*p[1]);
+      VEL(ix,iy).u[1] = -std::cos(kx*p[0])*std::sin(ky*p[1]);
+    }
+  }
+}
+
 void randomIC::operator()(const Real dt)
 {
+  sim.invalidateVel();
   const std::vector<BlockInfo>& chiInfo  = sim.chi->getBlocksInfo();
   const std::vector<BlockInfo>& presInfo = sim.pres->getBlocksInfo();
   const std::vector<BlockInfo>& poldInfo = sim.pold->getBlocksInfo();
@@ -154,6 +179,19 @@ void randomIC::operator()(const Real dt)
 
 Real findMaxU::run() const
 {
+  // complete the reduction of the maxima measured during the pressure
+  // correction and use them if the velocity has not changed since then
+  if (sim.uMaxRequest != MPI_REQUEST_NULL)
+  {
+    sim.perf->mpiStart();
+    MPI_Wait(&sim.uMaxRequest, MPI_STATUS_IGNORE);
+    sim.perf->mpiStop();
+  }
+  #ifndef ZERO_TOTAL_MOM
+  if (sim.uMaxVersion == sim.velVersion)
+    return std::max( { sim.uMaxPartial[0], sim.uMaxPartial[1], sim.uMaxPartial[2], sim.uMaxPartial[3] } );
+  #endif
+
   const size_t Nblocks = velInfo.size();
 
   const Real UINF = sim.uinfx, VINF = sim.uinfy;
@@ -173,7 +211,9 @@ Real findMaxU::run() const
     }
   }
   Real temp[3] = {momX,momY,totM};
+  sim.perf->mpiStart();
   MPI_Allreduce(MPI_IN_PLACE, temp, 3, MPI_Real, MPI_SUM, sim.chi->getWorldComm());
+  sim.perf->mpiStop();
   momX = temp[0];
   momY = temp[1];
   totM = temp[2];
@@ -198,7 +238,9 @@ Real findMaxU::run() const
     }
   }
   Real quantities[4] = {U,V,u,v};
+  sim.perf->mpiStart();
   MPI_Allreduce(MPI_IN_PLACE, quantities, 4, MPI_Real, MPI_MAX, sim.chi->getWorldComm());
+  sim.perf->mpiStop();
   U = quantities[0];
   V = quantities[1];
   u = quantities[2];
@@ -270,6 +312,7 @@ void ApplyObjVel::operator()(const Real dt)
   //deformation velocity UDEF to tmpV.
   //Then, we put that velocity to the grid.
 
+  sim.invalidateVel();
   const size_t Nblocks = velInfo.size();
   const std::vector<BlockInfo>& chiInfo  = sim.chi->getBlocksInfo();
   const std::vector<BlockInfo>& tmpVInfo = sim.tmpV->getBlocksInfo();
@@ -69,6 +69,21 @@ class gaussianIC : public Operator
   }
 };
 
+class taylorGreenIC : public Operator
+{
+  protected:
+  const std::vector<cubism::BlockInfo>& velInfo = sim.vel->getBlocksInfo();
+
+  public:
+  taylorGreenIC(SimulationData& s) : Operator(s) { }
+
+  void operator()(const Real dt);
+
+  std::string getName() {
+    return "taylorGreenIC";
+  }
+};
+
 class randomIC : public Operator
 {
   protected:
@@ -120,340 +120,368 @@ void ElasticCollision (const Real  m1,const Real  m2,
 
 }//namespace
 
-struct pressureCorrectionKernel
+void pressureCorrectionKernel::operator()(ScalarLab & P, const cubism::BlockInfo& info) const
 {
-  pressureCorrectionKernel(const SimulationData & s) : sim(s) {}
-  const SimulationData & sim;
-  const cubism::StencilInfo stencil{-1, -1, 0, 2, 2, 1, false, {0}};
-  const std::vector<cubism::BlockInfo>& tmpVInfo = sim.tmpV->getBlocksInfo();
-
-  void operator()(ScalarLab & P, const cubism::BlockInfo& info) const
+  const Real h = info.h, pFac = -0.5*sim.dt*h;
+  VectorBlock&__restrict__ tmpV = *(VectorBlock*)  tmpVInfo[info.blockID].ptrBlock;
+  for(int iy=0; iy<VectorBlock::sizeY; ++iy)
+  for(int ix=0; ix<VectorBlock::sizeX; ++ix)
+  {
+    tmpV(ix,iy).u[0] = pFac *(P(ix+1,iy).s-P(ix-1,iy).s);
+    tmpV(ix,iy).u[1] = pFac *(P(ix,iy+1).s-P(ix,iy-1).s);
+  }
+  BlockCase<VectorBlock> * tempCase = (BlockCase<VectorBlock> *)(tmpVInfo[info.blockID].auxiliary);
+  VectorBlock::ElementType * faceXm = nullptr;
+  VectorBlock::ElementType * faceXp = nullptr;
+  VectorBlock::ElementType * faceYm = nullptr;
+  VectorBlock::ElementType * faceYp = nullptr;
+  if (tempCase != nullptr)
   {
-    const Real h = info.h, pFac = -0.5*sim.dt*h;
-    VectorBlock&__restrict__ tmpV = *(VectorBlock*)  tmpVInfo[info.blockID].ptrBlock;
+    faceXm = tempCase -> storedFace[0] ?  & tempCase -> m_pData[0][0] : nullptr;
+    faceXp = tempCase -> storedFace[1] ?  & tempCase -> m_pData[1][0] : nullptr;
+    faceYm = tempCase -> storedFace[2] ?  & tempCase -> m_pData[2][0] : nullptr;
+    faceYp = tempCase -> storedFace[3] ?  & tempCase -> m_pData[3][0] : nullptr;
+  }
+  if (faceXm != nullptr)
+  {
+    int ix = 0;
     for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
     {
-      tmpV(ix,iy).u[0] = pFac *(P(ix+1,iy).s-P(ix-1,iy).s);
-      tmpV(ix,iy).u[1] = pFac *(P(ix,iy+1).s-P(ix,iy-1).s);
+      faceXm[iy].clear();
+      faceXm[iy].u[0] = pFac*(P(ix-1,iy).s+P(ix,iy).s);
     }
-    BlockCase<VectorBlock> * tempCase = (BlockCase<VectorBlock> *)(tmpVInfo[info.blockID].auxiliary);
-    VectorBlock::ElementType * faceXm = nullptr;
-    VectorBlock::ElementType * faceXp = nullptr;
-    VectorBlock::ElementType * faceYm = nullptr;
-    VectorBlock::ElementType * faceYp = nullptr;
-    if (tempCase != nullptr)
-    {
-      faceXm = tempCase -> storedFace[0] ?  & tempCase -> m_pData[0][0] : nullptr;
-      faceXp = tempCase -> storedFace[1] ?  & tempCase -> m_pData[1][0] : nullptr;
-      faceYm = tempCase -> storedFace[2] ?  & tempCase -> m_pData[2][0] : nullptr;
-      faceYp = tempCase -> storedFace[3] ?  & tempCase -> m_pData[3][0] : nullptr;
-    }
-    if (faceXm != nullptr)
+  }
+  if (faceXp != nullptr)
+  {
+    int ix = VectorBlock::sizeX-1;
+    for(int iy=0; iy<VectorBlock::sizeY; ++iy)
     {
-      int ix = 0;
-      for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-      {
-        faceXm[iy].clear();
-        faceXm[iy].u[0] = pFac*(P(ix-1,iy).s+P(ix,iy).s);
-      }
+      faceXp[iy].clear();
+      faceXp[iy].u[0] = -pFac*(P(ix+1,iy).s+P(ix,iy).s);
     }
-    if (faceXp != nullptr)
+  }
+  if (faceYm != nullptr)
+  {
+    int iy = 0;
+    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
     {
-      int ix = VectorBlock::sizeX-1;
-      for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-      {
-        faceXp[iy].clear();
-        faceXp[iy].u[0] = -pFac*(P(ix+1,iy).s+P(ix,iy).s);
-      }
+      faceYm[ix].clear();
+      faceYm[ix].u[1] = pFac*(P(ix,iy-1).s+P(ix,iy).s);
     }
-    if (faceYm != nullptr)
+  }
+  if (faceYp != nullptr)
+  {
+    int iy = VectorBlock::sizeY-1;
+    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
     {
-      int iy = 0;
-      for(int ix=0; ix<VectorBlock::sizeX; ++ix)
-      {
-        faceYm[ix].clear();
-        faceYm[ix].u[1] = pFac*(P(ix,iy-1).s+P(ix,iy).s);
-      }
-    }
-    if (faceYp != nullptr)
-    {
-      int iy = VectorBlock::sizeY-1;
-      for(int ix=0; ix<VectorBlock::sizeX; ++ix)
-      {
-        faceYp[ix].clear();
-        faceYp[ix].u[1] = -pFac*(P(ix,iy+1).s+P(ix,iy).s);
-      }
+      faceYp[ix].clear();
+      faceYp[ix].u[1] = -pFac*(P(ix,iy+1).s+P(ix,iy).s);
     }
   }
-};
+}
 
 void PressureSingle::pressureCorrection(const Real dt)
 {
   const pressureCorrectionKernel K(sim);
   cubism::compute<ScalarLab>(K,sim.pres,sim.tmpV);
 
+  // the velocity maxima needed by the next calcMaxTimestep are measured here
+  const Real UINF = sim.uinfx, VINF = sim.uinfy;
+  Real U = 0, V = 0, u = 0, v = 0;
   std::vector<cubism::BlockInfo>& tmpVInfo = sim.tmpV->getBlocksInfo();
-  #pragma omp parallel for
+  #pragma omp parallel for reduction(max : U, V, u, v)
   for (size_t i=0; i < velInfo.size(); i++)
   {
       const Real ih2 = 1.0/velInfo[i].h/velInfo[i].h;
-      VectorBlock&__restrict__   V = *(VectorBlock*)  velInfo[i].ptrBlock;
+      VectorBlock&__restrict__   VEL = *(VectorBlock*)  velInfo[i].ptrBlock;
       VectorBlock&__restrict__   tmpV = *(VectorBlock*) tmpVInfo[i].ptrBlock;
       for(int iy=0; iy<VectorBlock::sizeY; ++iy)
       for(int ix=0; ix<VectorBlock::sizeX; ++ix)
       {
-        V(ix,iy).u[0] += tmpV(ix,iy).u[0]*ih2;
-        V(ix,iy).u[1] += tmpV(ix,iy).u[1]*ih2;
+        VEL(ix,iy).u[0] += tmpV(ix,iy).u[0]*ih2;
+        VEL(ix,iy).u[1] += tmpV(ix,iy).u[1]*ih2;
+        U = std::max( U, std::fabs( VEL(ix,iy).u[0] + UINF ) );
+        V = std::max( V, std::fabs( VEL(ix,iy).u[1] + VINF ) );
+        u = std::max( u, std::fabs( VEL(ix,iy).u[0] ) );
+        v = std::max( v, std::fabs( VEL(ix,iy).u[1] ) );
       }
   }
+
+  // the reduction is completed in findMaxU::run
+  if (sim.uMaxRequest != MPI_REQUEST_NULL) MPI_Wait(&sim.uMaxRequest, MPI_STATUS_IGNORE);
+  sim.uMaxPartial[0] = U; sim.uMaxPartial[1] = V;
+  sim.uMaxPartial[2] = u; sim.uMaxPartial[3] = v;
+  MPI_Iallreduce(MPI_IN_PLACE, sim.uMaxPartial, 4, MPI_Real, MPI_MAX, sim.chi->getWorldComm(), &sim.uMaxRequest);
+  sim.uMaxVersion = sim.velVersion;
 }
 
-void PressureSingle::integrateMomenta(Shape * const shape) const
+void PressureSingle::findObstacleBlocks()
 {
   const size_t Nblocks = velInfo.size();
+  const size_t Nshapes = sim.shapes.size();
+  obstacleBlockIDs.clear();
+  obstacleShapeStart.assign(1, 0);
+  obstacleShapes.clear();
+  for (size_t i=0; i < Nblocks; i++)
+  {
+    for (size_t s=0; s < Nshapes; s++)
+      if (sim.shapes[s]->obstacleBlocks[velInfo[i].blockID] != nullptr)
+        obstacleShapes.push_back(s);
+    if (obstacleShapes.size() == obstacleShapeStart.back()) continue;
+    obstacleBlockIDs.push_back(i);
+    obstacleShapeStart.push_back(obstacleShapes.size());
+  }
+}
 
-  const std::vector<ObstacleBlock*> & OBLOCK = shape->obstacleBlocks;
-  const Real Cx = shape->centerOfMass[0];
-  const Real Cy = shape->centerOfMass[1];
-  Real PM=0, PJ=0, PX=0, PY=0, UM=0, VM=0, AM=0; //linear momenta
-
-  #pragma omp parallel for reduction(+:PM,PJ,PX,PY,UM,VM,AM)
-  for(size_t i=0; i<Nblocks; i++)
+void PressureSingle::integrateMomenta() const
+{
+  // Momenta of all shapes are integrated in one sweep over the obstacle
+  // blocks and reduced with a single Allreduce (7 values per shape).
+  const size_t Nblocks = obstacleBlockIDs.size();
+  const size_t Nshapes = sim.shapes.size();
+  if (Nshapes == 0) return;
+
+  std::vector<Real> quantities(7*Nshapes, 0.0);
+  Real * const Q = quantities.data();
+  #ifndef EXPL_INTEGRATE_MOM
+    const Real lambdt = sim.lambda * sim.dt;
+  #endif
+
+  #pragma omp parallel for reduction(+ : Q[:7*Nshapes])
+  for(size_t k=0; k<Nblocks; k++)
   {
+    const size_t i = obstacleBlockIDs[k];
     const VectorBlock& __restrict__ VEL = *(VectorBlock*)velInfo[i].ptrBlock;
     const Real hsq = velInfo[i].h*velInfo[i].h;
 
-    if(OBLOCK[velInfo[i].blockID] == nullptr) continue;
-    const CHI_MAT & __restrict__ chi = OBLOCK[velInfo[i].blockID]->chi;
-    const UDEFMAT & __restrict__ udef = OBLOCK[velInfo[i].blockID]->udef;
-    #ifndef EXPL_INTEGRATE_MOM
-      const Real lambdt = sim.lambda * sim.dt;
-    #endif
-
-    for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
+    for(size_t j=obstacleShapeStart[k]; j<obstacleShapeStart[k+1]; j++)
     {
-      if (chi[iy][ix] <= 0) continue;
-      const Real udiff[2] = {
-        VEL(ix,iy).u[0] - udef[iy][ix][0], VEL(ix,iy).u[1] - udef[iy][ix][1]
-      };
-      #ifdef EXPL_INTEGRATE_MOM
-        const Real F = hsq * chi[iy][ix];
-      #else
-        //const Real Xlamdt = chi[iy][ix] * lambdt;
-        //need to use unmollified version when H(x) appears in fractions
-        const Real Xlamdt = chi[iy][ix] >= 0.5 ? lambdt:0.0;
-        const Real F = hsq * Xlamdt / (1 + Xlamdt);
-      #endif
-      Real p[2]; velInfo[i].pos(p, ix, iy); p[0] -= Cx; p[1] -= Cy;
-      PM += F;
-      PJ += F * (p[0]*p[0] + p[1]*p[1]);
-      PX += F * p[0];  PY += F * p[1];
-      UM += F * udiff[0]; VM += F * udiff[1];
-      AM += F * (p[0]*udiff[1] - p[1]*udiff[0]);
+      const size_t s = obstacleShapes[j];
+      const auto & shape = sim.shapes[s];
+      const std::vector<ObstacleBlock*> & OBLOCK = shape->obstacleBlocks;
+      const Real Cx = shape->centerOfMass[0];
+      const Real Cy = shape->centerOfMass[1];
+      const CHI_MAT & __restrict__ chi = OBLOCK[velInfo[i].blockID]->chi;
+      const UDEFMAT & __restrict__ udef = OBLOCK[velInfo[i].blockID]->udef;
+      Real PM=0, PJ=0, PX=0, PY=0, UM=0, VM=0, AM=0; //linear momenta
+
+      for(int iy=0; iy<VectorBlock::sizeY; ++iy)
+      for(int ix=0; ix<VectorBlock::sizeX; ++ix)
+      {
+        if (chi[iy][ix] <= 0) continue;
+        const Real udiff[2] = {
+          VEL(ix,iy).u[0] - udef[iy][ix][0], VEL(ix,iy).u[1] - udef[iy][ix][1]
+        };
+        #ifdef EXPL_INTEGRATE_MOM
+          const Real F = hsq * chi[iy][ix];
+        #else
+          //const Real Xlamdt = chi[iy][ix] * lambdt;
+          //need to use unmollified version when H(x) appears in fractions
+          const Real Xlamdt = chi[iy][ix] >= 0.5 ? lambdt:0.0;
+          const Real F = hsq * Xlamdt / (1 + Xlamdt);
+        #endif
+        Real p[2]; velInfo[i].pos(p, ix, iy); p[0] -= Cx; p[1] -= Cy;
+        PM += F;
+        PJ += F * (p[0]*p[0] + p[1]*p[1]);
+        PX += F * p[0];  PY += F * p[1];
+        UM += F * udiff[0]; VM += F * udiff[1];
+        AM += F * (p[0]*udiff[1] - p[1]*udiff[0]);
+      }
+      Real * const q = Q + 7*s;
+      q[0] += PM; q[1] += PJ; q[2] += PX; q[3] += PY;
+      q[4] += UM; q[5] += VM; q[6] += AM;
     }
   }
-  Real quantities[7] = {PM,PJ,PX,PY,UM,VM,AM};
-  MPI_Allreduce(MPI_IN_PLACE, quantities, 7, MPI_Real, MPI_SUM, sim.chi->getWorldComm());
-  PM = quantities[0]; 
-  PJ = quantities[1]; 
-  PX = quantities[2]; 
-  PY = quantities[3]; 
-  UM = quantities[4]; 
-  VM = quantities[5]; 
-  AM = quantities[6];
-
-  shape->fluidAngMom = AM; shape->fluidMomX = UM; shape->fluidMomY = VM;
-  shape->penalDX=PX; shape->penalDY=PY; shape->penalM=PM; shape->penalJ=PJ;
+  sim.perf->mpiStart();
+  MPI_Allreduce(MPI_IN_PLACE, Q, (int)(7*Nshapes), MPI_Real, MPI_SUM, sim.chi->getWorldComm());
+  sim.perf->mpiStop();
+
+  for(size_t s=0; s<Nshapes; s++)
+  {
+    Shape * const shape = sim.shapes[s].get();
+    const Real * const q = Q + 7*s;
+    shape->penalM = q[0]; shape->penalJ = q[1];
+    shape->penalDX = q[2]; shape->penalDY = q[3];
+    shape->fluidMomX = q[4]; shape->fluidMomY = q[5]; shape->fluidAngMom = q[6];
+  }
 }
 
 void PressureSingle::penalize(const Real dt) const
 {
   std::vector<cubism::BlockInfo>& chiInfo   = sim.chi->getBlocksInfo();
 
-  const size_t Nblocks = velInfo.size();
+  const size_t Nblocks = obstacleBlockIDs.size();
+  #ifndef EXPL_INTEGRATE_MOM
+    //need to use unmollified version when H(x) appears in fractions
+    const Real alphaIn = 1/(1 + sim.lambda * dt);
+  #endif
 
-  #pragma omp parallel for
-  for (size_t i=0; i < Nblocks; i++)
-  for (const auto& shape : sim.shapes)
+  // Only the blocks that intersect an obstacle are visited, and all shapes
+  // present in a block are applied to it in one pass.
+  #pragma omp parallel for schedule(dynamic,1)
+  for (size_t k=0; k < Nblocks; k++)
   {
-    const std::vector<ObstacleBlock*>& OBLOCK = shape->obstacleBlocks;
-    const ObstacleBlock*const o = OBLOCK[velInfo[i].blockID];
-    if (o == nullptr) continue;
+    const cubism::BlockInfo & info = velInfo[obstacleBlockIDs[k]];
+    const ScalarBlock& __restrict__ CHI = *(ScalarBlock*)chiInfo[obstacleBlockIDs[k]].ptrBlock;
+          VectorBlock& __restrict__   V = *(VectorBlock*)info.ptrBlock;
+    for (size_t j=obstacleShapeStart[k]; j < obstacleShapeStart[k+1]; j++)
+    {
+      const Shape * const shape = sim.shapes[obstacleShapes[j]].get();
+      const ObstacleBlock*const o = shape->obstacleBlocks[info.blockID];
 
-    const Real u_s = shape->u;
-    const Real v_s = shape->v;
-    const Real omega_s = shape->omega;
-    const Real Cx = shape->centerOfMass[0];
-    const Real Cy = shape->centerOfMass[1];
+      const Real u_s = shape->u;
+      const Real v_s = shape->v;
+      const Real omega_s = shape->omega;
+      const Real Cx = shape->centerOfMass[0];
+      const Real Cy = shape->centerOfMass[1];
 
-    const CHI_MAT & __restrict__ X = o->chi;
-    const UDEFMAT & __restrict__ UDEF = o->udef;
-    const ScalarBlock& __restrict__ CHI = *(ScalarBlock*)chiInfo[i].ptrBlock;
-          VectorBlock& __restrict__   V = *(VectorBlock*)velInfo[i].ptrBlock;
+      const CHI_MAT & __restrict__ X = o->chi;
+      const UDEFMAT & __restrict__ UDEF = o->udef;
 
-    for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
-    {
-      // What if multiple obstacles share a block? Do not write udef onto
-      // grid if CHI stored on the grid is greater than obst's CHI.
-      if(CHI(ix,iy).s > X[iy][ix]) continue;
-      if(X[iy][ix] <= 0) continue; // no need to do anything
-
-      Real p[2];
-      velInfo[i].pos(p, ix, iy);
-      p[0] -= Cx;
-      p[1] -= Cy;
-      #ifndef EXPL_INTEGRATE_MOM
-        //const Real alpha = 1/(1 + sim.lambda * dt * X[iy][ix]);
-        //need to use unmollified version when H(x) appears in fractions
-        const Real alpha = X[iy][ix] > 0.5 ? 1/(1 + sim.lambda * dt) : 1;
-      #else
-        const Real alpha = 1 - X[iy][ix];
-      #endif
-
-      const Real US = u_s - omega_s * p[1] + UDEF[iy][ix][0];
-      const Real VS = v_s + omega_s * p[0] + UDEF[iy][ix][1];
-      V(ix,iy).u[0] = alpha*V(ix,iy).u[0] + (1-alpha)*US;
-      V(ix,iy).u[1] = alpha*V(ix,iy).u[1] + (1-alpha)*VS;
+      for(int iy=0; iy<VectorBlock::sizeY; ++iy)
+      {
+        const Real py = info.origin[1] + info.h*(iy+0.5) - Cy;
+        #pragma omp simd
+        for(int ix=0; ix<VectorBlock::sizeX; ++ix)
+        {
+          const Real px = info.origin[0] + info.h*(ix+0.5) - Cx;
+          // What if multiple obstacles share a block? Do not write udef onto
+          // grid if CHI stored on the grid is greater than obst's CHI.
+          // Cells that are not penalized get alpha = 1 (no branch).
+          const bool inside = X[iy][ix] > 0 && CHI(ix,iy).s <= X[iy][ix];
+          #ifndef EXPL_INTEGRATE_MOM
+            const Real alpha = (inside && X[iy][ix] > 0.5) ? alphaIn : 1;
+          #else
+            const Real alpha = inside ? 1 - X[iy][ix] : 1;
+          #endif
+
+          const Real US = u_s - omega_s * py + UDEF[iy][ix][0];
+          const Real VS = v_s + omega_s * px + UDEF[iy][ix][1];
+          V(ix,iy).u[0] = alpha*V(ix,iy).u[0] + (1-alpha)*US;
+          V(ix,iy).u[1] = alpha*V(ix,iy).u[1] + (1-alpha)*VS;
+        }
+      }
     }
   }
 }
 
-struct updatePressureRHS
+void updatePressureRHS::operator()(VectorLab & velLab, VectorLab & uDefLab, ScalarLab & presLab, const cubism::BlockInfo& info) const
 {
-  // RHS of Poisson equation is div(u) - chi * div(u_def)
-  // It is computed here and stored in TMP
-
-  updatePressureRHS(const SimulationData & s) : sim(s) {}
-  const SimulationData & sim;
-  cubism::StencilInfo stencil{-1, -1, 0, 2, 2, 1, false, {0,1}};
-  cubism::StencilInfo stencil2{-1, -1, 0, 2, 2, 1, false, {0,1}};
-  const std::vector<cubism::BlockInfo>& tmpInfo = sim.tmp->getBlocksInfo();
-  const std::vector<cubism::BlockInfo>& chiInfo = sim.chi->getBlocksInfo();
-
-  void operator()(VectorLab & velLab, VectorLab & uDefLab, const cubism::BlockInfo& info, const cubism::BlockInfo& info2) const
+  const Real h = info.h;
+  const Real facDiv = 0.5*h/sim.dt;
+  ScalarBlock& __restrict__ TMP = *(ScalarBlock*) tmpInfo[info.blockID].ptrBlock;
+  ScalarBlock& __restrict__ CHI = *(ScalarBlock*) chiInfo[info.blockID].ptrBlock;
+  for(int iy=0; iy<VectorBlock::sizeY; ++iy)
+  for(int ix=0; ix<VectorBlock::sizeX; ++ix)
   {
-    const Real h = info.h;
-    const Real facDiv = 0.5*h/sim.dt;
-    ScalarBlock& __restrict__ TMP = *(ScalarBlock*) tmpInfo[info.blockID].ptrBlock;
-    ScalarBlock& __restrict__ CHI = *(ScalarBlock*) chiInfo[info.blockID].ptrBlock;
+    TMP(ix, iy).s  =   facDiv                *( (velLab(ix+1,iy).u[0] -  velLab(ix-1,iy).u[0])
+                                             +  (velLab(ix,iy+1).u[1] -  velLab(ix,iy-1).u[1]));
+    TMP(ix, iy).s += - facDiv * CHI(ix,iy).s *((uDefLab(ix+1,iy).u[0] - uDefLab(ix-1,iy).u[0])
+                                             + (uDefLab(ix,iy+1).u[1] - uDefLab(ix,iy-1).u[1]));
+    TMP(ix, iy).s -=  ( ((presLab(ix-1,iy).s + presLab(ix+1,iy).s) + (presLab(ix,iy-1).s + presLab(ix,iy+1).s)) - 4.0*presLab(ix,iy).s);
+  }
+  BlockCase<ScalarBlock> * tempCase = (BlockCase<ScalarBlock> *)(tmpInfo[info.blockID].auxiliary);
+  ScalarBlock::ElementType * faceXm = nullptr;
+  ScalarBlock::ElementType * faceXp = nullptr;
+  ScalarBlock::ElementType * faceYm = nullptr;
+  ScalarBlock::ElementType * faceYp = nullptr;
+  if (tempCase != nullptr)
+  {
+    faceXm = tempCase -> storedFace[0] ?  & tempCase -> m_pData[0][0] : nullptr;
+    faceXp = tempCase -> storedFace[1] ?  & tempCase -> m_pData[1][0] : nullptr;
+    faceYm = tempCase -> storedFace[2] ?  & tempCase -> m_pData[2][0] : nullptr;
+    faceYp = tempCase -> storedFace[3] ?  & tempCase -> m_pData[3][0] : nullptr;
+  }
+  // face fluxes of both contributions, corrected together
+  if (faceXm != nullptr)
+  {
+    int ix = 0;
     for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
     {
-      TMP(ix, iy).s  =   facDiv                *( (velLab(ix+1,iy).u[0] -  velLab(ix-1,iy).u[0])
-                                               +  (velLab(ix,iy+1).u[1] -  velLab(ix,iy-1).u[1]));
-      TMP(ix, iy).s += - facDiv * CHI(ix,iy).s *((uDefLab(ix+1,iy).u[0] - uDefLab(ix-1,iy).u[0])
-                                               + (uDefLab(ix,iy+1).u[1] - uDefLab(ix,iy-1).u[1]));
+      faceXm[iy].s  =  facDiv                *( velLab(ix-1,iy).u[0] +  velLab(ix,iy).u[0]) ;
+      faceXm[iy].s += -(facDiv * CHI(ix,iy).s)*(uDefLab(ix-1,iy).u[0] + uDefLab(ix,iy).u[0]) ;
+      faceXm[iy].s += presLab(ix-1,iy).s - presLab(ix,iy).s;
     }
-    BlockCase<ScalarBlock> * tempCase = (BlockCase<ScalarBlock> *)(tmpInfo[info.blockID].auxiliary);
-    ScalarBlock::ElementType * faceXm = nullptr;
-    ScalarBlock::ElementType * faceXp = nullptr;
-    ScalarBlock::ElementType * faceYm = nullptr;
-    ScalarBlock::ElementType * faceYp = nullptr;
-    if (tempCase != nullptr)
-    {
-      faceXm = tempCase -> storedFace[0] ?  & tempCase -> m_pData[0][0] : nullptr;
-      faceXp = tempCase -> storedFace[1] ?  & tempCase -> m_pData[1][0] : nullptr;
-      faceYm = tempCase -> storedFace[2] ?  & tempCase -> m_pData[2][0] : nullptr;
-      faceYp = tempCase -> storedFace[3] ?  & tempCase -> m_pData[3][0] : nullptr;
-    }
-    if (faceXm != nullptr)
-    {
-      int ix = 0;
-      for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-      {
-        faceXm[iy].s  =  facDiv                *( velLab(ix-1,iy).u[0] +  velLab(ix,iy).u[0]) ;
-        faceXm[iy].s += -(facDiv * CHI(ix,iy).s)*(uDefLab(ix-1,iy).u[0] + uDefLab(ix,iy).u[0]) ;
-      }
-    }
-    if (faceXp != nullptr)
+  }
+  if (faceXp != nullptr)
+  {
+    int ix = VectorBlock::sizeX-1;
+    for(int iy=0; iy<VectorBlock::sizeY; ++iy)
     {
-      int ix = VectorBlock::sizeX-1;
-      for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-      {
-        faceXp[iy].s  = -facDiv               *( velLab(ix+1,iy).u[0] +  velLab(ix,iy).u[0]);
-        faceXp[iy].s -= -(facDiv *CHI(ix,iy).s)*(uDefLab(ix+1,iy).u[0] + uDefLab(ix,iy).u[0]);
-      }
+      faceXp[iy].s  = -facDiv               *( velLab(ix+1,iy).u[0] +  velLab(ix,iy).u[0]);
+      faceXp[iy].s -= -(facDiv *CHI(ix,iy).s)*(uDefLab(ix+1,iy).u[0] + uDefLab(ix,iy).u[0]);
+      faceXp[iy].s += presLab(ix+1,iy).s - presLab(ix,iy).s;
     }
-    if (faceYm != nullptr)
+  }
+  if (faceYm != nullptr)
+  {
+    int iy = 0;
+    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
     {
-      int iy = 0;
-      for(int ix=0; ix<VectorBlock::sizeX; ++ix)
-      {
-        faceYm[ix].s  =  facDiv               *( velLab(ix,iy-1).u[1] +  velLab(ix,iy).u[1]);
-        faceYm[ix].s += -(facDiv *CHI(ix,iy).s)*(uDefLab(ix,iy-1).u[1] + uDefLab(ix,iy).u[1]);
-      }
+      faceYm[ix].s  =  facDiv               *( velLab(ix,iy-1).u[1] +  velLab(ix,iy).u[1]);
+      faceYm[ix].s += -(facDiv *CHI(ix,iy).s)*(uDefLab(ix,iy-1).u[1] + uDefLab(ix,iy).u[1]);
+      faceYm[ix].s += presLab(ix,iy-1).s - presLab(ix,iy).s;
     }
-    if (faceYp != nullptr)
+  }
+  if (faceYp != nullptr)
+  {
+    int iy = VectorBlock::sizeY-1;
+    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
     {
-      int iy = VectorBlock::sizeY-1;
-      for(int ix=0; ix<VectorBlock::sizeX; ++ix)
-      {
-        faceYp[ix].s  = -facDiv               *( velLab(ix,iy+1).u[1] +  velLab(ix,iy).u[1]);
-        faceYp[ix].s -= -(facDiv *CHI(ix,iy).s)*(uDefLab(ix,iy+1).u[1] + uDefLab(ix,iy).u[1]);
-      }
+      faceYp[ix].s  = -facDiv               *( velLab(ix,iy+1).u[1] +  velLab(ix,iy).u[1]);
+      faceYp[ix].s -= -(facDiv *CHI(ix,iy).s)*(uDefLab(ix,iy+1).u[1] + uDefLab(ix,iy).u[1]);
+      faceYp[ix].s += presLab(ix,iy+1).s - presLab(ix,iy).s;
     }
   }
-};
+}
 
-struct updatePressureRHS1
+// Three-grid version of cubism::compute: the halos of vel, tmpV and pres are
+// exchanged at the same time and all three share the same stencil extent, so
+// the lists of interior and halo blocks of the three synchronizers coincide.
+void computePressureRHS(SimulationData & sim)
 {
-  // RHS of Poisson equation is div(u) - chi * div(u_def)
-  // It is computed here and stored in TMP
-
-  updatePressureRHS1(const SimulationData & s) : sim(s) {}
-  const SimulationData & sim;
-  cubism::StencilInfo stencil{-1, -1, 0, 2, 2, 1, false, {0}};
-  const std::vector<cubism::BlockInfo>& tmpInfo = sim.tmp->getBlocksInfo();
-  const std::vector<cubism::BlockInfo>& poldInfo = sim.pold->getBlocksInfo();
-
-  void operator()(ScalarLab & lab, const cubism::BlockInfo& info) const
+  const updatePressureRHS K(sim);
+  sim.tmp->Corrector.prepare(*sim.tmp);
+
+  cubism::SynchronizerMPI_AMR<Real,VectorGrid>& Synch1 = *sim.vel ->sync(K.stencil );
+  cubism::SynchronizerMPI_AMR<Real,VectorGrid>& Synch2 = *sim.tmpV->sync(K.stencil2);
+  cubism::SynchronizerMPI_AMR<Real,ScalarGrid>& Synch3 = *sim.pres->sync(K.stencil3);
+  const cubism::StencilInfo& stencil1 = Synch1.getstencil();
+  const cubism::StencilInfo& stencil2 = Synch2.getstencil();
+  const cubism::StencilInfo& stencil3 = Synch3.getstencil();
+
+  // interior blocks first (while halos are in flight), then the halo blocks
+  std::vector<cubism::BlockInfo*> avail1 = Synch1.avail_inner();
+  std::vector<cubism::BlockInfo*> avail2 = Synch2.avail_inner();
+  std::vector<cubism::BlockInfo*> avail3 = Synch3.avail_inner();
+  for (int pass = 0; pass < 2; pass++)
   {
-    ScalarBlock& __restrict__ TMP = *(ScalarBlock*) tmpInfo[info.blockID].ptrBlock;
-    for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
-      TMP(ix, iy).s  -=  ( ((lab(ix-1,iy).s + lab(ix+1,iy).s) + (lab(ix,iy-1).s + lab(ix,iy+1).s)) - 4.0*lab(ix,iy).s);
-
-    BlockCase<ScalarBlock> * tempCase = (BlockCase<ScalarBlock> *)(tmpInfo[info.blockID].auxiliary);
-    ScalarBlock::ElementType * faceXm = nullptr;
-    ScalarBlock::ElementType * faceXp = nullptr;
-    ScalarBlock::ElementType * faceYm = nullptr;
-    ScalarBlock::ElementType * faceYp = nullptr;
-    if (tempCase != nullptr)
+    if (pass == 1)
     {
-      faceXm = tempCase -> storedFace[0] ?  & tempCase -> m_pData[0][0] : nullptr;
-      faceXp = tempCase -> storedFace[1] ?  & tempCase -> m_pData[1][0] : nullptr;
-      faceYm = tempCase -> storedFace[2] ?  & tempCase -> m_pData[2][0] : nullptr;
-      faceYp = tempCase -> storedFace[3] ?  & tempCase -> m_pData[3][0] : nullptr;
+      avail1 = Synch1.avail_halo();
+      avail2 = Synch2.avail_halo();
+      avail3 = Synch3.avail_halo();
     }
-    if (faceXm != nullptr)
+    #pragma omp parallel
     {
-      int ix = 0;
-      for(int iy=0; iy<ScalarBlock::sizeY; ++iy)
-        faceXm[iy] = lab(ix-1,iy) - lab(ix,iy);
-    }
-    if (faceXp != nullptr)
-    {
-      int ix = ScalarBlock::sizeX-1;
-      for(int iy=0; iy<ScalarBlock::sizeY; ++iy)
-        faceXp[iy] = lab(ix+1,iy) - lab(ix,iy);
-    }
-    if (faceYm != nullptr)
-    {
-      int iy = 0;
-      for(int ix=0; ix<ScalarBlock::sizeX; ++ix)
-        faceYm[ix] = lab(ix,iy-1) - lab(ix,iy);
-    }
-    if (faceYp != nullptr)
-    {
-      int iy = ScalarBlock::sizeY-1;
-      for(int ix=0; ix<ScalarBlock::sizeX; ++ix)
-        faceYp[ix] = lab(ix,iy+1) - lab(ix,iy);
+      VectorLab lab1, lab2;
+      ScalarLab lab3;
+      lab1.prepare(*sim.vel , stencil1);
+      lab2.prepare(*sim.tmpV, stencil2);
+      lab3.prepare(*sim.pres, stencil3);
+      #pragma omp for schedule(dynamic,1)
+      for (size_t i = 0; i < avail1.size(); i++)
+      {
+        lab1.load(*avail1[i], 0);
+        lab2.load(*avail2[i], 0);
+        lab3.load(*avail3[i], 0);
+        K(lab1, lab2, lab3, *avail1[i]);
+      }
     }
   }
-};
+
+  sim.tmp->Corrector.FillBlockCases();
+}
 
 void PressureSingle::preventCollidingObstacles() const
 {
@@ -628,7 +656,9 @@ void PressureSingle::preventCollidingObstacles() const
         buffer[20*i + 19] = coll.jvecZ;
 
     }
+    sim.perf->mpiStart();
     MPI_Allreduce(MPI_IN_PLACE, buffer.data(), buffer.size(), MPI_Real, MPI_SUM, sim.chi->getWorldComm());
+    sim.perf->mpiStop();
     for (size_t i = 0 ; i < N ; i++)
     {
         auto & coll = collisions[i];
@@ -783,11 +813,10 @@ void PressureSingle::operator()(const Real dt)
   sim.startProfiler("Pressure");
   const size_t Nblocks = velInfo.size();
 
-  // update velocity of obstacle
-  for(const auto& shape : sim.shapes) {
-    integrateMomenta(shape.get());
-    shape->updateVelocity(dt);
-  }
+  // update velocity of obstacles
+  findObstacleBlocks();
+  integrateMomenta();
+  for(const auto& shape : sim.shapes) shape->updateVelocity(dt);
   // take care if two obstacles collide
   preventCollidingObstacles();
 
@@ -801,34 +830,28 @@ void PressureSingle::operator()(const Real dt)
   #pragma omp parallel for
   for (size_t i=0; i < Nblocks; i++)
   {
-    ( (VectorBlock*) tmpVInfo[i].ptrBlock )->clear();
-  }
-  for(const auto& shape : sim.shapes)
-  {
-    const std::vector<ObstacleBlock*>& OBLOCK = shape->obstacleBlocks;
-    #pragma omp parallel for
-    for (size_t i=0; i < Nblocks; i++)
+    auto & __restrict__ UDEF = *(VectorBlock*)tmpVInfo[i].ptrBlock; // dest
+    const ScalarBlock&__restrict__ CHI  = *(ScalarBlock*) chiInfo[i].ptrBlock;
+    UDEF.clear();
+    for(const auto& shape : sim.shapes)
     {
-      if(OBLOCK[tmpVInfo[i].blockID] == nullptr) continue; //obst not in block
-      const UDEFMAT & __restrict__ udef = OBLOCK[tmpVInfo[i].blockID]->udef;
-      const CHI_MAT & __restrict__ chi  = OBLOCK[tmpVInfo[i].blockID]->chi;
-      auto & __restrict__ UDEF = *(VectorBlock*)tmpVInfo[i].ptrBlock; // dest
-      const ScalarBlock&__restrict__ CHI  = *(ScalarBlock*) chiInfo[i].ptrBlock;
+      const ObstacleBlock*const o = shape->obstacleBlocks[tmpVInfo[i].blockID];
+      if(o == nullptr) continue; //obst not in block
+      const UDEFMAT & __restrict__ udef = o->udef;
+      const CHI_MAT & __restrict__ chi  = o->chi;
       for(int iy=0; iy<VectorBlock::sizeY; iy++)
+      #pragma omp simd
       for(int ix=0; ix<VectorBlock::sizeX; ix++)
       {
-         if( chi[iy][ix] < CHI(ix,iy).s) continue;
-         Real p[2]; tmpVInfo[i].pos(p, ix, iy);
-         UDEF(ix, iy).u[0] += udef[iy][ix][0];
-         UDEF(ix, iy).u[1] += udef[iy][ix][1];
+         const Real w = chi[iy][ix] < CHI(ix,iy).s ? 0 : 1;
+         UDEF(ix, iy).u[0] += w*udef[iy][ix][0];
+         UDEF(ix, iy).u[1] += w*udef[iy][ix][1];
       }
     }
   }
-  updatePressureRHS K(sim);
-  compute<updatePressureRHS,VectorGrid,VectorLab,VectorGrid,VectorLab,ScalarGrid>(K,*sim.vel,*sim.tmpV,true,sim.tmp);
-
+  // RHS with the old pressure, which is then the initial guess
+  computePressureRHS(sim);
 
-  //Add p_old (+dp/dt) to RHS
   const std::vector<cubism::BlockInfo>& presInfo = sim.pres->getBlocksInfo();
   const std::vector<cubism::BlockInfo>& poldInfo = sim.pold->getBlocksInfo();
   
@@ -845,9 +868,8 @@ void PressureSingle::operator()(const Real dt)
       PRES  (ix,iy).s = 0;
     }
   }
-  updatePressureRHS1 K1(sim);
-  cubism::compute<ScalarLab>(K1,sim.pold,sim.tmp);
 
+  if (tolerance.enabled()) tolerance.beforeSolve();
   pressureSolver->solve(sim.tmp, sim.pres);
 
   Real avg = 0;
@@ -865,7 +887,9 @@ void PressureSingle::operator()(const Real dt)
     }
   }
   Real quantities[2] = {avg,avg1};
+  sim.perf->mpiStart();
   MPI_Allreduce(MPI_IN_PLACE,&quantities,2,MPI_Real,MPI_SUM,sim.comm);
+  sim.perf->mpiStop();
   avg = quantities[0]; avg1 = quantities[1] ;
   avg = avg/avg1;
   #pragma omp parallel for
@@ -881,12 +905,15 @@ void PressureSingle::operator()(const Real dt)
   // apply pressure correction
   pressureCorrection(dt);
 
+  if (tolerance.enabled()) tolerance.afterProjection(dt);
+
   sim.stopProfiler();
 }
 
 PressureSingle::PressureSingle(SimulationData& s) :
   Operator{s},
-  pressureSolver{makePoissonSolver(s)}
+  pressureSolver{makePoissonSolver(s)},
+  tolerance{s}
 { }
 
 PressureSingle::~PressureSingle() = default;
@@ -11,6 +11,37 @@
 class Shape;
 
 #include "../Poisson/Base.h"
+#include "../Poisson/AdaptiveTolerance.h"
+
+struct pressureCorrectionKernel
+{
+  pressureCorrectionKernel(const SimulationData & s) : sim(s) {}
+  const SimulationData & sim;
+  const cubism::StencilInfo stencil{-1, -1, 0, 2, 2, 1, false, {0}};
+  const std::vector<cubism::BlockInfo>& tmpVInfo = sim.tmpV->getBlocksInfo();
+
+  void operator()(ScalarLab & P, const cubism::BlockInfo& info) const;
+};
+
+struct updatePressureRHS
+{
+  // RHS of Poisson equation is div(u) - chi * div(u_def) - lap(p_old)
+  // It is computed here and stored in TMP
+
+  updatePressureRHS(const SimulationData & s) : sim(s) {}
+  const SimulationData & sim;
+  cubism::StencilInfo stencil{-1, -1, 0, 2, 2, 1, false, {0,1}};
+  cubism::StencilInfo stencil2{-1, -1, 0, 2, 2, 1, false, {0,1}};
+  cubism::StencilInfo stencil3{-1, -1, 0, 2, 2, 1, false, {0}};
+  const std::vector<cubism::BlockInfo>& tmpInfo = sim.tmp->getBlocksInfo();
+  const std::vector<cubism::BlockInfo>& chiInfo = sim.chi->getBlocksInfo();
+
+  void operator()(VectorLab & velLab, VectorLab & uDefLab, ScalarLab & presLab, const cubism::BlockInfo& info) const;
+};
+
+// Runs updatePressureRHS with labs of vel, tmpV (u_def) and pres (p_old) in
+// one pass and applies the flux correction of tmp once.
+void computePressureRHS(SimulationData & sim);
 
 class PressureSingle : public Operator
 {
@@ -18,10 +49,18 @@ protected:
   const std::vector<cubism::BlockInfo>& velInfo = sim.vel->getBlocksInfo();
 
   std::shared_ptr<PoissonSolver> pressureSolver;
+  AdaptiveTolerance tolerance;
+
+  // Local blocks that intersect some obstacle (obstacleBlockIDs, indices in
+  // velInfo) and the shapes present in each of them: those of block k are
+  // obstacleShapes[obstacleShapeStart[k] .. obstacleShapeStart[k+1]).
+  // Built once per step by findObstacleBlocks.
+  std::vector<size_t> obstacleBlockIDs, obstacleShapeStart, obstacleShapes;
+  void findObstacleBlocks();
 
   void preventCollidingObstacles() const;
   void pressureCorrection(const Real dt);
-  void integrateMomenta(Shape * const shape) const;
+  void integrateMomenta() const;
   void penalize(const Real dt) const;
 
  public:
@@ -30,6 +69,8 @@ protected:
   PressureSingle(SimulationData& s);
   ~PressureSingle();
 
+  unsigned writes() const override { return OP_VEL | OP_PRES | OP_POLD | OP_TMP | OP_TMPV | OP_SHAPES; }
+
   std::string getName() override
   {
     return "PressureSingle";
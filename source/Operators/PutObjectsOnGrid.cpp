@@ -6,6 +6,8 @@
 
 #include "PutObjectsOnGrid.h"
 #include "../Shape.h"
+#include "../Obstacles/Fish.h"
+#include "../Obstacles/FishData.h"
 #include "../Utils/BufferedLogger.h"
 
 using namespace cubism;
@@ -45,68 +47,61 @@ struct ComputeSurfaceNormals
   }
 };
 
-struct PutChiOnGrid
+void PutChiOnGrid::operator()(ScalarLab & lab, const BlockInfo& info) const
 {
-  PutChiOnGrid(const SimulationData & s) : sim(s) {}
-  const SimulationData & sim;
-  const StencilInfo stencil{-1, -1, 0, 2, 2, 1, false, {0}};
-  const std::vector<cubism::BlockInfo>& chiInfo = sim.chi->getBlocksInfo();
-  void operator()(ScalarLab & lab, const BlockInfo& info) const
+  for(const auto& shape : sim.shapes)
   {
-    for(const auto& shape : sim.shapes)
+    const std::vector<ObstacleBlock*>& OBLOCK = shape->obstacleBlocks;
+    if(OBLOCK[info.blockID] == nullptr) continue; //obst not in block
+    const Real h = info.h;
+    const Real h2 = h*h;
+    ObstacleBlock& o = * OBLOCK[info.blockID];
+    CHI_MAT & __restrict__ X = o.chi;
+    const CHI_MAT & __restrict__ sdf = o.dist;
+    o.COM_x = 0;
+    o.COM_y = 0;
+    o.Mass  = 0;
+    auto & __restrict__ CHI  = *(ScalarBlock*) chiInfo[info.blockID].ptrBlock;
+    for(int iy=0; iy<ScalarBlock::sizeY; iy++)
+    for(int ix=0; ix<ScalarBlock::sizeX; ix++)
     {
-      const std::vector<ObstacleBlock*>& OBLOCK = shape->obstacleBlocks;
-      if(OBLOCK[info.blockID] == nullptr) continue; //obst not in block
-      const Real h = info.h;
-      const Real h2 = h*h;
-      ObstacleBlock& o = * OBLOCK[info.blockID];
-      CHI_MAT & __restrict__ X = o.chi;
-      const CHI_MAT & __restrict__ sdf = o.dist;
-      o.COM_x = 0;
-      o.COM_y = 0;
-      o.Mass  = 0;
-      auto & __restrict__ CHI  = *(ScalarBlock*) chiInfo[info.blockID].ptrBlock;
-      for(int iy=0; iy<ScalarBlock::sizeY; iy++)
-      for(int ix=0; ix<ScalarBlock::sizeX; ix++)
+      #if 0
+      X[iy][ix] = sdf[iy][ix] > 0 ? 1 : 0;
+      #else //Towers mollified Heaviside
+      if (sdf[iy][ix] > +h || sdf[iy][ix] < -h)
       {
-        #if 0
         X[iy][ix] = sdf[iy][ix] > 0 ? 1 : 0;
-        #else //Towers mollified Heaviside
-        if (sdf[iy][ix] > +h || sdf[iy][ix] < -h)
-        {
-          X[iy][ix] = sdf[iy][ix] > 0 ? 1 : 0;
-        }
-        else
-        {
-          const Real distPx = lab(ix+1,iy).s;
-          const Real distMx = lab(ix-1,iy).s;
-          const Real distPy = lab(ix,iy+1).s;
-          const Real distMy = lab(ix,iy-1).s;
-          const Real IplusX = std::max((Real)0.0,distPx);
-          const Real IminuX = std::max((Real)0.0,distMx);
-          const Real IplusY = std::max((Real)0.0,distPy);
-          const Real IminuY = std::max((Real)0.0,distMy);
-          const Real gradIX = IplusX-IminuX;
-          const Real gradIY = IplusY-IminuY;
-          const Real gradUX = distPx-distMx;
-          const Real gradUY = distPy-distMy;
-          const Real gradUSq = (gradUX * gradUX + gradUY * gradUY) + EPS;
-          X[iy][ix] = (gradIX*gradUX + gradIY*gradUY)/ gradUSq;
-        }
-        #endif
-        CHI(ix,iy).s = std::max(CHI(ix,iy).s,X[iy][ix]);
-        if(X[iy][ix] > 0)
-        {
-          Real p[2];
-          info.pos(p, ix, iy);
-          o.COM_x += X[iy][ix] * h2 * (p[0] - shape->centerOfMass[0]);
-          o.COM_y += X[iy][ix] * h2 * (p[1] - shape->centerOfMass[1]);
-          o.Mass  += X[iy][ix] * h2;
-        }
+      }
+      else
+      {
+        const Real distPx = lab(ix+1,iy).s;
+        const Real distMx = lab(ix-1,iy).s;
+        const Real distPy = lab(ix,iy+1).s;
+        const Real distMy = lab(ix,iy-1).s;
+        const Real IplusX = std::max((Real)0.0,distPx);
+        const Real IminuX = std::max((Real)0.0,distMx);
+        const Real IplusY = std::max((Real)0.0,distPy);
+        const Real IminuY = std::max((Real)0.0,distMy);
+        const Real gradIX = IplusX-IminuX;
+        const Real gradIY = IplusY-IminuY;
+        const Real gradUX = distPx-distMx;
+        const Real gradUY = distPy-distMy;
+        const Real gradUSq = (gradUX * gradUX + gradUY * gradUY) + EPS;
+        X[iy][ix] = (gradIX*gradUX + gradIY*gradUY)/ gradUSq;
+      }
+      #endif
+      CHI(ix,iy).s = std::max(CHI(ix,iy).s,X[iy][ix]);
+      if(X[iy][ix] > 0)
+      {
+        Real p[2];
+        info.pos(p, ix, iy);
+        o.COM_x += X[iy][ix] * h2 * (p[0] - shape->centerOfMass[0]);
+        o.COM_y += X[iy][ix] * h2 * (p[1] - shape->centerOfMass[1]);
+        o.Mass  += X[iy][ix] * h2;
       }
     }
   }
-};
+}
 
 void PutObjectsOnGrid::operator()(const Real dt)
 {
@@ -144,6 +139,70 @@ void PutObjectsOnGrid::advanceShapes(const Real dt)
   }
 }
 
+// Every rank advances the gait state of all fish (cheap, and it must stay
+// identical on all ranks), then fish i solves its midline on rank i % size
+// (the fish of a rank are distributed over its threads) and the midline arrays
+// of all fish are exchanged with one Allgatherv, instead of every rank solving
+// all of them. Fish that cannot split their midline computation are left to
+// Fish::create.
+void PutObjectsOnGrid::computeMidlines()
+{
+  std::vector<Fish*> fish;
+  for(const auto& shape : sim.shapes)
+  {
+    Fish * const f = dynamic_cast<Fish*>(shape.get());
+    if (f != nullptr && f->myFish->distributeMidline()) fish.push_back(f);
+  }
+  if (fish.empty()) return;
+  for (Fish * const f : fish) f->myFish->updateGait(sim.time, sim.dt);
+
+  int size;
+  MPI_Comm_size(sim.chi->getWorldComm(), &size);
+  const int nFish = (int)fish.size();
+  std::vector<int> counts(size, 0), displs(size, 0);
+  std::vector<int> offset(nFish);
+  for (int i = 0; i < nFish; i++) counts[i % size] += 8 * fish[i]->myFish->Nm;
+  for (int r = 1; r < size; r++) displs[r] = displs[r-1] + counts[r-1];
+  {
+    std::vector<int> pos(displs);
+    for (int i = 0; i < nFish; i++)
+    {
+      offset[i] = pos[i % size];
+      pos[i % size] += 8 * fish[i]->myFish->Nm;
+    }
+  }
+  std::vector<Real> buffer(displs[size-1] + counts[size-1]);
+
+  std::vector<int> mine;
+  for (int i = sim.rank; i < nFish; i += size) mine.push_back(i);
+  #pragma omp parallel for schedule(dynamic,1) if(mine.size() > 1)
+  for (size_t k = 0; k < mine.size(); k++)
+  {
+    FishData & F = *fish[mine[k]]->myFish;
+    F.solveMidline(sim.time, sim.dt);
+    const int Nm = F.Nm;
+    Real * const out = buffer.data() + offset[mine[k]];
+    const Real * const src[8] = {F.rX, F.rY, F.vX, F.vY, F.norX, F.norY, F.vNorX, F.vNorY};
+    for (int j = 0; j < 8; j++) std::copy(src[j], src[j] + Nm, out + j*Nm);
+  }
+
+  sim.perf->mpiStart();
+  MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, buffer.data(), counts.data(),
+                 displs.data(), MPI_Real, sim.chi->getWorldComm());
+  sim.perf->mpiStop();
+
+  for (int i = 0; i < nFish; i++)
+  {
+    FishData & F = *fish[i]->myFish;
+    const int Nm = F.Nm;
+    const Real * const in = buffer.data() + offset[i];
+    Real * const dst[8] = {F.rX, F.rY, F.vX, F.vY, F.norX, F.norY, F.vNorX, F.vNorY};
+    if (i % size != sim.rank)
+      for (int j = 0; j < 8; j++) std::copy(in + j*Nm, in + (j+1)*Nm, dst[j]);
+    fish[i]->midlineReady = true;
+  }
+}
+
 void PutObjectsOnGrid::putObjectsOnGrid()
 {
   const size_t Nblocks = velInfo.size();
@@ -157,6 +216,7 @@ void PutObjectsOnGrid::putObjectsOnGrid()
   }
 
   // 2) Compute signed dist function and udef
+  if (sim.bDistributeMidlines) computeMidlines();
   for(const auto& shape : sim.shapes)
     shape->create(tmpInfo);
 
@@ -177,7 +237,9 @@ void PutObjectsOnGrid::putObjectsOnGrid()
       com[1] += OBLOCK[i]->COM_x;
       com[2] += OBLOCK[i]->COM_y;
     }
+    sim.perf->mpiStart();
     MPI_Allreduce(MPI_IN_PLACE, com, 3, MPI_Real, MPI_SUM, sim.chi->getWorldComm());
+    sim.perf->mpiStop();
     shape->M = com[0];
     shape->centerOfMass[0] += com[1]/com[0];
     shape->centerOfMass[1] += com[2]/com[0];
@@ -10,6 +10,15 @@
 
 class Shape;
 
+struct PutChiOnGrid
+{
+  PutChiOnGrid(const SimulationData & s) : sim(s) {}
+  const SimulationData & sim;
+  const cubism::StencilInfo stencil{-1, -1, 0, 2, 2, 1, false, {0}};
+  const std::vector<cubism::BlockInfo>& chiInfo = sim.chi->getBlocksInfo();
+  void operator()(ScalarLab & lab, const cubism::BlockInfo& info) const;
+};
+
 class PutObjectsOnGrid : public Operator
 {
 protected:
@@ -18,6 +27,7 @@ protected:
   const std::vector<cubism::BlockInfo>& chiInfo   = sim.chi->getBlocksInfo();
 
   void putChiOnGrid(Shape * const shape) const;
+  void computeMidlines();
 
  public:
   using Operator::Operator;
@@ -26,6 +36,8 @@ protected:
   void advanceShapes(Real dt);
   void putObjectsOnGrid();
 
+  unsigned writes() const override { return OP_CHI | OP_TMP | OP_SHAPES; }
+
   std::string getName() override
   {
     return "PutObjectsOnGrid";
@@ -136,83 +136,80 @@ static inline Real dV_adv_dif(const VectorLab&V, const Real uinf[2], const Real
 }
 
 
-struct KernelAdvectDiffuse
+void KernelAdvectDiffuse::operator()(VectorLab& lab, const BlockInfo& info) const
 {
-  KernelAdvectDiffuse(const SimulationData & s) : sim(s)
+  const Real h = info.h;
+  const Real dfac = sim.nu*sim.dt;
+  const Real afac = -sim.dt*h;
+  VectorBlock & __restrict__ TMP = *(VectorBlock*) tmpVInfo[info.blockID].ptrBlock;
+  for(int iy=0; iy<VectorBlock::sizeY; ++iy)
+  for(int ix=0; ix<VectorBlock::sizeX; ++ix)
   {
-    uinf[0] = sim.uinfx;
-    uinf[1] = sim.uinfy;
+    TMP(ix,iy).u[0] = dU_adv_dif(lab,uinf,afac,dfac,ix,iy);
+    TMP(ix,iy).u[1] = dV_adv_dif(lab,uinf,afac,dfac,ix,iy);
   }
-  const SimulationData & sim;
-  Real uinf [2];
-  const StencilInfo stencil{-3, -3, 0, 4, 4, 1, true, {0,1}};
-  const std::vector<cubism::BlockInfo>& tmpVInfo = sim.tmpV->getBlocksInfo();
-
-  void operator()(VectorLab& lab, const BlockInfo& info) const
+  if (saveOld)
   {
-    const Real h = info.h;
-    const Real dfac = sim.nu*sim.dt;
-    const Real afac = -sim.dt*h;
-    VectorBlock & __restrict__ TMP = *(VectorBlock*) tmpVInfo[info.blockID].ptrBlock;
+    VectorBlock & __restrict__ Vold = *(VectorBlock*) vOldInfo[info.blockID].ptrBlock;
     for(int iy=0; iy<VectorBlock::sizeY; ++iy)
     for(int ix=0; ix<VectorBlock::sizeX; ++ix)
     {
-      TMP(ix,iy).u[0] = dU_adv_dif(lab,uinf,afac,dfac,ix,iy);
-      TMP(ix,iy).u[1] = dV_adv_dif(lab,uinf,afac,dfac,ix,iy);
+      Vold(ix,iy).u[0] = lab(ix,iy).u[0];
+      Vold(ix,iy).u[1] = lab(ix,iy).u[1];
     }
-    BlockCase<VectorBlock> * tempCase = (BlockCase<VectorBlock> *)(tmpVInfo[info.blockID].auxiliary);
-    VectorBlock::ElementType * faceXm = nullptr;
-    VectorBlock::ElementType * faceXp = nullptr;
-    VectorBlock::ElementType * faceYm = nullptr;
-    VectorBlock::ElementType * faceYp = nullptr;
+  }
+  BlockCase<VectorBlock> * tempCase = (BlockCase<VectorBlock> *)(tmpVInfo[info.blockID].auxiliary);
+  VectorBlock::ElementType * faceXm = nullptr;
+  VectorBlock::ElementType * faceXp = nullptr;
+  VectorBlock::ElementType * faceYm = nullptr;
+  VectorBlock::ElementType * faceYp = nullptr;
 
-    const Real aux_coef = dfac;
+  const Real aux_coef = dfac;
 
-    if (tempCase != nullptr)
-    {
-      faceXm = tempCase -> storedFace[0] ?  & tempCase -> m_pData[0][0] : nullptr;
-      faceXp = tempCase -> storedFace[1] ?  & tempCase -> m_pData[1][0] : nullptr;
-      faceYm = tempCase -> storedFace[2] ?  & tempCase -> m_pData[2][0] : nullptr;
-      faceYp = tempCase -> storedFace[3] ?  & tempCase -> m_pData[3][0] : nullptr;
-    }
-    if (faceXm != nullptr)
+  if (tempCase != nullptr)
+  {
+    faceXm = tempCase -> storedFace[0] ?  & tempCase -> m_pData[0][0] : nullptr;
+    faceXp = tempCase -> storedFace[1] ?  & tempCase -> m_pData[1][0] : nullptr;
+    faceYm = tempCase -> storedFace[2] ?  & tempCase -> m_pData[2][0] : nullptr;
+    faceYp = tempCase -> storedFace[3] ?  & tempCase -> m_pData[3][0] : nullptr;
+  }
+  if (faceXm != nullptr)
+  {
+    int ix = 0;
+    for(int iy=0; iy<VectorBlock::sizeY; ++iy)
     {
-      int ix = 0;
-      for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-      {
-        faceXm[iy].u[0] = aux_coef*(lab(ix,iy).u[0] - lab(ix-1,iy).u[0]);
-        faceXm[iy].u[1] = aux_coef*(lab(ix,iy).u[1] - lab(ix-1,iy).u[1]);
-      }
+      faceXm[iy].u[0] = aux_coef*(lab(ix,iy).u[0] - lab(ix-1,iy).u[0]);
+      faceXm[iy].u[1] = aux_coef*(lab(ix,iy).u[1] - lab(ix-1,iy).u[1]);
     }
-    if (faceXp != nullptr)
+  }
+  if (faceXp != nullptr)
+  {
+    int ix = VectorBlock::sizeX-1;
+    for(int iy=0; iy<VectorBlock::sizeY; ++iy)
     {
-      int ix = VectorBlock::sizeX-1;
-      for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-      {
-        faceXp[iy].u[0] = aux_coef*(lab(ix,iy).u[0] - lab(ix+1,iy).u[0]);
-        faceXp[iy].u[1] = aux_coef*(lab(ix,iy).u[1] - lab(ix+1,iy).u[1]);
-      }
+      faceXp[iy].u[0] = aux_coef*(lab(ix,iy).u[0] - lab(ix+1,iy).u[0]);
+      faceXp[iy].u[1] = aux_coef*(lab(ix,iy).u[1] - lab(ix+1,iy).u[1]);
     }
-    if (faceYm != nullptr)
+  }
+  if (faceYm != nullptr)
+  {
+    int iy = 0;
+    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
     {
-      int iy = 0;
-      for(int ix=0; ix<VectorBlock::sizeX; ++ix)
-      {
-        faceYm[ix].u[0] = aux_coef*(lab(ix,iy).u[0] - lab(ix,iy-1).u[0]);
-        faceYm[ix].u[1] = aux_coef*(lab(ix,iy).u[1] - lab(ix,iy-1).u[1]);
-      }
+      faceYm[ix].u[0] = aux_coef*(lab(ix,iy).u[0] - lab(ix,iy-1).u[0]);
+      faceYm[ix].u[1] = aux_coef*(lab(ix,iy).u[1] - lab(ix,iy-1).u[1]);
     }
-    if (faceYp != nullptr)
+  }
+  if (faceYp != nullptr)
+  {
+    int iy = VectorBlock::sizeY-1;
+    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
     {
-      int iy = VectorBlock::sizeY-1;
-      for(int ix=0; ix<VectorBlock::sizeX; ++ix)
-      {
-        faceYp[ix].u[0] = aux_coef*(lab(ix,iy).u[0] - lab(ix,iy+1).u[0]);
-        faceYp[ix].u[1] = aux_coef*(lab(ix,iy).u[1] - lab(ix,iy+1).u[1]);
-      }
+      faceYp[ix].u[0] = aux_coef*(lab(ix,iy).u[0] - lab(ix,iy+1).u[0]);
+      faceYp[ix].u[1] = aux_coef*(lab(ix,iy).u[1] - lab(ix,iy+1).u[1]);
     }
   }
-};
+}
 
 
 void advDiff::operator()(const Real dt)
@@ -221,24 +218,14 @@ void advDiff::operator()(const Real dt)
   const size_t Nblocks = velInfo.size();
   KernelAdvectDiffuse Step1(sim) ;
 
-  //1.Save u^{n} to dataOld
-  #pragma omp parallel for
-  for (size_t i=0; i < Nblocks; i++)
-  {
-    VectorBlock & __restrict__ Vold  = *(VectorBlock*) vOldInfo[i].ptrBlock;
-    const VectorBlock & __restrict__ V  = *(VectorBlock*)  velInfo[i].ptrBlock;
-    for(int iy=0; iy<VectorBlock::sizeY; ++iy)
-    for(int ix=0; ix<VectorBlock::sizeX; ++ix)
-    {
-      Vold(ix,iy).u[0] = V(ix,iy).u[0];
-      Vold(ix,iy).u[1] = V(ix,iy).u[1];
-    }
-  }
-
   /********************************************************************/
+  // 1. Save u^{n} to dataOld (done by the kernel of step 2a, block by block,
+  //    so that it overlaps with the halo exchange of u^{n})
   // 2. Set u^{n+1/2} = u^{n} + 0.5*dt*RHS(u^{n})
   //   2a) Compute 0.5*dt*RHS(u^{n}) and store it to tmpU,tmpV,tmpW
+  Step1.saveOld = true;
   cubism::compute<VectorLab>(Step1,sim.vel,sim.tmpV);
+  Step1.saveOld = false;
 
   //   2b) Set u^{n+1/2} = u^{n} + 0.5*dt*RHS(u^{n})
   #pragma omp parallel for
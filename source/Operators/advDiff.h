@@ -9,6 +9,25 @@
 #include "../Operator.h"
 #include "Cubism/FluxCorrection.h"
 
+struct KernelAdvectDiffuse
+{
+  KernelAdvectDiffuse(const SimulationData & s) : sim(s)
+  {
+    uinf[0] = sim.uinfx;
+    uinf[1] = sim.uinfy;
+  }
+  const SimulationData & sim;
+  Real uinf [2];
+  const cubism::StencilInfo stencil{-3, -3, 0, 4, 4, 1, true, {0,1}};
+  const std::vector<cubism::BlockInfo>& tmpVInfo = sim.tmpV->getBlocksInfo();
+  const std::vector<cubism::BlockInfo>& vOldInfo = sim.vOld->getBlocksInfo();
+  // also copy the velocity to vOld; this block-local work then runs while the
+  // halo exchange of compute() is in flight instead of in a separate sweep
+  bool saveOld = false;
+
+  void operator()(VectorLab& lab, const cubism::BlockInfo& info) const;
+};
+
 class advDiff : public Operator
 {
 protected:
@@ -21,6 +40,8 @@ protected:
 
   void operator() (const Real dt) override;
 
+  unsigned writes() const override { return OP_VEL | OP_VOLD | OP_TMPV; }
+
   std::string getName() override
   {
     return "advDiff";
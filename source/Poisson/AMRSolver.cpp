@@ -74,6 +74,110 @@ void AMRSolver::getZ(Real * input, BlockInfo & zInfo)
 }
 
 
+void AMRSolver::getZpolynomial(Real * input) const
+{
+  // The block Laplacian with zero values outside the block is A = 4 - (sum of
+  // the 4 neighbours); like getZ, this returns -p(A) r with p(A) ~ A^{-1}.
+  constexpr int BSX = VectorBlock::sizeX;
+  constexpr int BSY = VectorBlock::sizeY;
+  constexpr int PX  = BSX + 2; // padded arrays with a layer of zeros
+  Real r[BSX*BSY];
+  Real z[(BSX+2)*(BSY+2)] = {};
+  Real d[(BSX+2)*(BSY+2)] = {};
+  for (int i = 0; i < BSX*BSY; i++) r[i] = input[i];
+
+  if (preconditioner == Preconditioner::Neumann)
+  {
+    // A = 4(I - N): A^{-1} ~ 1/4 sum_k N^k, evaluated with Horner's scheme
+    Real * zk = z, * zn = d;
+    for (int iy = 0; iy < BSY; iy++)
+    for (int ix = 0; ix < BSX; ix++)
+      zk[(iy+1)*PX+ix+1] = 0.25*r[iy*BSX+ix];
+    for (int k = 0; k < polyDegree; k++)
+    {
+      for (int iy = 0; iy < BSY; iy++)
+      #pragma omp simd
+      for (int ix = 0; ix < BSX; ix++)
+      {
+        const int j = (iy+1)*PX+ix+1;
+        zn[j] = 0.25*(r[iy*BSX+ix] + zk[j-1] + zk[j+1] + zk[j-PX] + zk[j+PX]);
+      }
+      std::swap(zk, zn);
+    }
+    if (zk != z)
+      for (int j = 0; j < (BSX+2)*(BSY+2); j++) z[j] = zk[j];
+  }
+  else
+  {
+    // Chebyshev iteration (Saad, Alg. 12.1) with z0 = 0 and the eigenvalues
+    // 4 -+ 4cos(pi/(BS+1)) of the block Laplacian as bounds
+    const Real c = std::cos(M_PI/(std::max(BSX,BSY)+1));
+    const Real theta = 4.0, delta = 4.0*c;
+    const Real sigma = theta/delta;
+    Real rho = 1.0/sigma;
+    for (int iy = 0; iy < BSY; iy++)
+    for (int ix = 0; ix < BSX; ix++)
+      d[(iy+1)*PX+ix+1] = r[iy*BSX+ix]/theta;
+    for (int k = 0; k < polyDegree; k++)
+    {
+      const Real rhoNew = 1.0/(2*sigma - rho);
+      for (int iy = 0; iy < BSY; iy++)
+      #pragma omp simd
+      for (int ix = 0; ix < BSX; ix++)
+      {
+        const int j = (iy+1)*PX+ix+1;
+        z[j] += d[j];
+        r[iy*BSX+ix] -= 4*d[j] - (d[j-1] + d[j+1] + d[j-PX] + d[j+PX]);
+      }
+      for (int iy = 0; iy < BSY; iy++)
+      #pragma omp simd
+      for (int ix = 0; ix < BSX; ix++)
+      {
+        const int j = (iy+1)*PX+ix+1;
+        d[j] = rhoNew*rho*d[j] + 2*rhoNew/delta*r[iy*BSX+ix];
+      }
+      rho = rhoNew;
+    }
+  }
+
+  for (int iy = 0; iy < BSY; iy++)
+  for (int ix = 0; ix < BSX; ix++)
+    input[iy*BSX+ix] = -z[(iy+1)*PX+ix+1];
+}
+
+void AMRSolver::startReduction(Real * data, const int n)
+{
+  MPI_Iallreduce(MPI_IN_PLACE,data,n,MPI_Real,MPI_SUM,sim.chi->getWorldComm(),&reduction);
+  reductionDone = false;
+  reductionPosted = MPI_Wtime();
+  reductionCompleted = 0;
+}
+
+void AMRSolver::progressReduction()
+{
+  if (reductionDone) return;
+  int flag = 0;
+  MPI_Test(&reduction,&flag,MPI_STATUS_IGNORE);
+  if (flag)
+  {
+    reductionDone = true;
+    reductionCompleted = MPI_Wtime();
+  }
+}
+
+void AMRSolver::waitReduction()
+{
+  const double t0 = MPI_Wtime();
+  sim.perf->mpiStart();
+  if (!reductionDone) MPI_Wait(&reduction,MPI_STATUS_IGNORE);
+  sim.perf->mpiStop();
+  const double t1 = MPI_Wtime();
+  reductionDone = true;
+  // hidden: from posting until completion was observed or the wait started
+  const double hidden = (reductionCompleted > 0 ? reductionCompleted : t0) - reductionPosted;
+  sim.perf->addPoissonReduction(hidden, t1 - t0);
+}
+
 Real AMRSolver::getA_local(const int I1,const int I2)
 {
   const int BSX = VectorBlock::sizeX;
@@ -95,8 +199,18 @@ Real AMRSolver::getA_local(const int I1,const int I2)
   }
 }
 
-AMRSolver::AMRSolver(SimulationData& ss):sim(ss),Get_LHS(ss)
+AMRSolver::AMRSolver(SimulationData& ss):sim(ss),Get_LHS(ss),coarse(ss)
 {
+  if      (sim.poissonPreconditioner == "cholesky" ) preconditioner = Preconditioner::Cholesky;
+  else if (sim.poissonPreconditioner == "neumann"  ) preconditioner = Preconditioner::Neumann;
+  else if (sim.poissonPreconditioner == "chebyshev") preconditioner = Preconditioner::Chebyshev;
+  else
+    throw std::invalid_argument(
+        "Poisson preconditioner: \"" + sim.poissonPreconditioner + "\" unrecognized!");
+  polyDegree = sim.poissonPolyDegree;
+  if (preconditioner != Preconditioner::Cholesky && polyDegree < 1)
+    throw std::invalid_argument("Poisson preconditioner: -poissonPolyDegree must be positive!");
+
   const int BSX = VectorBlock::sizeX;
   const int BSY = VectorBlock::sizeY;
   const int N = BSX*BSY;
@@ -247,7 +361,9 @@ void AMRSolver::solve(const ScalarGrid *input, ScalarGrid * const output)
       norm += r0[j]*r0[j];
     }
     Real temporary[3] = {temp0,temp1,norm};
+    sim.perf->mpiStart();
     MPI_Allreduce(MPI_IN_PLACE,temporary,3,MPI_Real,MPI_SUM,m_comm);
+    sim.perf->mpiStop();
     alpha = temporary[0]/(temporary[1]+eps);
     r0r_prev = temporary[0];
     norm = std::sqrt(temporary[2]);
@@ -303,11 +419,10 @@ void AMRSolver::solve(const ScalarGrid *input, ScalarGrid * const output)
     }
 
     //(*12*) begin reduction (q,y),(y,y)
-    MPI_Request request;
     Real quantities[7];
     quantities[0] = qy;
     quantities[1] = yy;
-    MPI_Iallreduce(MPI_IN_PLACE,&quantities,2,MPI_Real,MPI_SUM,m_comm,&request);
+    startReduction(quantities,2);
 
     //(*13*) computation zhat = M^{-1}*z
     _preconditioner(z,zhat);
@@ -316,7 +431,7 @@ void AMRSolver::solve(const ScalarGrid *input, ScalarGrid * const output)
     _lhs(zhat,v);
 
     //(*15*) end reduction
-    MPI_Waitall(1,&request,MPI_STATUSES_IGNORE);
+    waitReduction();
     qy = quantities[0];
     yy = quantities[1];
 
@@ -387,7 +502,7 @@ void AMRSolver::solve(const ScalarGrid *input, ScalarGrid * const output)
     quantities[6] = norm;
 
     //(*21*) begin reductions
-    MPI_Iallreduce(MPI_IN_PLACE,&quantities,7,MPI_Real,MPI_SUM,m_comm,&request );
+    startReduction(quantities,7);
 
     //(*22*) computation what = M^{-1}*w
     _preconditioner(w,what);
@@ -396,7 +511,7 @@ void AMRSolver::solve(const ScalarGrid *input, ScalarGrid * const output)
     _lhs(what,t);
 
     //(*24*) end reductions
-    MPI_Waitall(1,&request,MPI_STATUSES_IGNORE);
+    waitReduction();
     r0r = quantities[0];
     r0w = quantities[1];
     r0s = quantities[2];
@@ -440,14 +555,13 @@ void AMRSolver::solve(const ScalarGrid *input, ScalarGrid * const output)
         temp0 += r0[j]*r0[j];
         temp1 += r0[j]*w [j];
       }
-      MPI_Request request2;
       Real temporary[2] = {temp0,temp1};
-      MPI_Iallreduce(MPI_IN_PLACE, temporary,2,MPI_Real,MPI_SUM,m_comm,&request2);
+      startReduction(temporary,2);
     
       _preconditioner(w,what);
       _lhs(what,t);
     
-      MPI_Waitall(1,&request2,MPI_STATUSES_IGNORE);
+      waitReduction();
     
       alpha = temporary[0]/(temporary[1]+eps);
       r0r_prev = temporary[0];
@@ -475,6 +589,7 @@ void AMRSolver::solve(const ScalarGrid *input, ScalarGrid * const output)
   {
     std::cout <<  " Error norm (relative) = " << min_norm << "/" << max_error << std::endl;
   }
+  sim.perf->addPoissonSolve(std::min(k+1, sim.maxPoissonIterations), restarts, init_norm, min_norm);
 
   Real * solution = useXopt ? x_opt.data() : x.data();
   #pragma omp parallel for
@@ -8,9 +8,11 @@
 
 #include "../Operator.h"
 #include "Base.h"
+#include "CoarseCorrection.h"
 
 class ComputeLHS : public Operator
 {
+ public:
   struct LHSkernel
   {
     LHSkernel(const SimulationData & ss) : sim(ss) {}
@@ -138,18 +140,57 @@ class AMRSolver : public PoissonSolver
   void getZ(Real * input,cubism::BlockInfo & zInfo);
   Real getA_local(const int I1, const int I2);
 
+  // Block-local preconditioner, chosen with -poissonPreconditioner:
+  // "cholesky"  exact solve with the block Laplacian (getZ),
+  // "neumann"   truncated Neumann series of the Jacobi-scaled block Laplacian,
+  // "chebyshev" Chebyshev iteration with the known spectral bounds of the
+  //             block Laplacian.
+  // The polynomial variants only apply the 5-point stencil inside the block
+  // (-poissonPolyDegree times) and vectorize.
+  enum class Preconditioner { Cholesky, Neumann, Chebyshev };
+  Preconditioner preconditioner;
+  int polyDegree;
+  void getZpolynomial(Real * input) const;
+  CoarseCorrection coarse;
+
+  // The dot products of each iteration are reduced with MPI_Iallreduce while
+  // the preconditioner and the LHS are applied. Most MPI libraries only make
+  // progress on it when they are entered, so the master thread calls
+  // MPI_Test every -poissonProgressBatch blocks it preconditions (0 = never).
+  // The time the reduction was hidden and the time spent waiting for it are
+  // reported to sim.perf.
+  MPI_Request reduction = MPI_REQUEST_NULL;
+  bool reductionDone = true;
+  double reductionPosted = 0, reductionCompleted = 0;
+  void startReduction(Real * data, const int n);
+  void progressReduction();
+  void waitReduction();
+
   void _preconditioner(const std::vector<Real> & input, std::vector<Real> & output)
   {
     auto &  zInfo         = sim.pres->getBlocksInfo(); //used for preconditioning
     const size_t Nblocks  = zInfo.size();
     const int BSX         = VectorBlock::sizeX;
     const int BSY         = VectorBlock::sizeY;
+    const int batch       = sim.poissonProgressBatch;
 
     #pragma omp parallel for
     for (size_t i = 0 ; i < input.size(); i ++) output[i] = input[i];
 
-    #pragma omp parallel for
-    for (size_t i=0; i < Nblocks; i++) getZ(&output[i*BSX*BSY],zInfo[i]);
+    #pragma omp parallel
+    {
+      const bool master = omp_get_thread_num() == 0 && batch > 0;
+      int done = 0;
+      #pragma omp for
+      for (size_t i=0; i < Nblocks; i++)
+      {
+        if (preconditioner == Preconditioner::Cholesky) getZ(&output[i*BSX*BSY],zInfo[i]);
+        else getZpolynomial(&output[i*BSX*BSY]);
+        if (master && ++done % batch == 0) progressReduction();
+      }
+    }
+
+    if (sim.bPoissonCoarse) coarse.apply(input, output);
   }
 
   void _lhs(std::vector<Real> & input, std::vector<Real> & output)
@@ -172,6 +213,7 @@ class AMRSolver : public PoissonSolver
       }
     }
 
+    progressReduction();
     Get_LHS(0);
 
     #pragma omp parallel for
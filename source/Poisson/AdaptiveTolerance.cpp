@@ -0,0 +1,97 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "AdaptiveTolerance.h"
+#include "../Operators/Helpers.h"
+#include "../Utils/BufferedLogger.h"
+
+#include <iomanip>
+
+AdaptiveTolerance::AdaptiveTolerance(SimulationData& s) :
+  sim(s), tolMin(s.PoissonTol), maxIters(s.maxPoissonIterations),
+  tol(s.PoissonTol), cap(s.maxPoissonIterations)
+{ }
+
+void AdaptiveTolerance::beforeSolve()
+{
+  sim.PoissonTol = tol;
+  sim.maxPoissonIterations = cap;
+}
+
+Real AdaptiveTolerance::measureDivergence() const
+{
+  const KernelDivergence K(sim);
+  cubism::compute<VectorLab>(K,sim.vel,sim.tmp);
+
+  const std::vector<cubism::BlockInfo>& tmpInfo = sim.tmp->getBlocksInfo();
+  Real div = 0;
+  #pragma omp parallel for reduction(+:div)
+  for (size_t i=0; i < tmpInfo.size(); i++)
+  {
+    const ScalarBlock & __restrict__ TMP = *(ScalarBlock*) tmpInfo[i].ptrBlock;
+    for(int iy=0; iy<ScalarBlock::sizeY; ++iy)
+    for(int ix=0; ix<ScalarBlock::sizeX; ++ix)
+      div += TMP(ix,iy).s * TMP(ix,iy).s;
+  }
+  sim.perf->mpiStart();
+  MPI_Allreduce(MPI_IN_PLACE, &div, 1, MPI_Real, MPI_SUM, sim.comm);
+  sim.perf->mpiStop();
+  return std::sqrt(div);
+}
+
+void AdaptiveTolerance::afterProjection(const Real dt)
+{
+  const PerfReport::PoissonStats & stats = sim.perf->getPoisson();
+  itersSolve = stats.iterations;
+  normSolve  = stats.finalResidual;
+  if (stats.solves > 0)
+    itersAvg = itersAvg < 0 ? itersSolve : 0.8*itersAvg + 0.2*itersSolve;
+
+  // divergence in units of the Poisson residual (RHS is h^2 div(u) / dt)
+  const Real div = measureDivergence() / dt;
+  const Real target = sim.PoissonTolFactor * div;
+
+  std::string reason;
+  if (sim.step < 10)
+  {
+    // the solver runs to full accuracy during the first steps anyway
+    tol = tolMin;
+    cap = maxIters;
+    reason = "startup";
+  }
+  else if (divPrev > 0 && div > 2*divPrev)
+  {
+    tol = tolMin;
+    cap = maxIters;
+    reason = "divergence_growth";
+  }
+  else if (itersSolve >= cap && normSolve > tol)
+  {
+    tol = tolMin;
+    cap = maxIters;
+    reason = "cap_reached";
+  }
+  else
+  {
+    tol = std::min(std::max(target, tol/2), 2*tol);
+    tol = std::min(std::max(tol, tolMin), sim.PoissonTolMax);
+    cap = std::min(std::max((int)std::ceil(3*itersAvg), 20), maxIters);
+    reason = tol == target ? "divergence" : "clamped";
+  }
+  divPrev = div;
+  log(div, target, reason);
+}
+
+void AdaptiveTolerance::log(const Real div, const Real target, const std::string & reason) const
+{
+  if (sim.rank != 0 || sim.muteAll) return;
+  std::stringstream & f = logger.get_stream(sim.path2file + "/poissonTolerance.dat");
+  if (sim.step == 0)
+    f << "step time dt divergence target tol cap iterations residual reason\n";
+  f << std::setprecision(6) << sim.step << " " << sim.time << " " << sim.dt << " "
+    << div << " " << target << " " << tol << " " << cap << " "
+    << itersSolve << " " << normSolve << " " << reason << "\n";
+}
@@ -0,0 +1,63 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#pragma once
+
+#include "../SimulationData.h"
+
+#include <string>
+
+/*
+ * Per-step controller of the Poisson tolerance and iteration cap.
+ *
+ * After each projection the divergence left in the velocity field is
+ * measured (L2 norm of h^2 div(u), divided by dt to be in the units of the
+ * Poisson residual). Solving the next pressure equation much below that
+ * level does not improve the projection, so the absolute tolerance of the
+ * next solve is set to `PoissonTolFactor` times this divergence.
+ *
+ * Guard rails:
+ *  - the tolerance stays in [PoissonTol, PoissonTolMax], where PoissonTol is
+ *    the value given with -poissonTol,
+ *  - it changes by at most a factor 2 per step,
+ *  - if the divergence grows by more than a factor 2 in one step, or if the
+ *    last solve hit the iteration cap before converging, the tolerance is
+ *    reset to PoissonTol and the cap to maxPoissonIterations,
+ *  - the cap is 3x the running average of the iterations (at least 20).
+ * Every decision is appended (rank 0) to `poissonTolerance.dat`.
+ *
+ * The controller overwrites sim.PoissonTol and sim.maxPoissonIterations
+ * before every solve; all inputs are global reductions, so every rank takes
+ * the same decision.
+ */
+class AdaptiveTolerance
+{
+ public:
+  AdaptiveTolerance(SimulationData& s);
+
+  bool enabled() const { return sim.bAdaptivePoissonTol; }
+
+  // set sim.PoissonTol and sim.maxPoissonIterations for this step's solve
+  void beforeSolve();
+
+  // measure the divergence of the projected velocity and choose the
+  // tolerance of the next step (collective, overwrites sim.tmp)
+  void afterProjection(const Real dt);
+
+ private:
+  SimulationData& sim;
+  const Real tolMin;     // -poissonTol
+  const int  maxIters;   // -maxPoissonIterations
+  Real tol;              // tolerance for the next solve
+  int  cap;              // iteration cap for the next solve
+  Real divPrev = -1;     // divergence measured after the previous step
+  Real itersAvg = -1;    // running average of the iterations per solve
+  int  itersSolve = 0;   // iterations and final residual of the last solve
+  Real normSolve = 0;
+
+  Real measureDivergence() const;
+  void log(Real div, Real target, const std::string & reason) const;
+};
@@ -1,5 +1,6 @@
 #include "Base.h"
 #include "AMRSolver.h"
+#include "SStepSolver.h"
 #ifdef GPU_POISSON
 #include "ExpAMRSolver.h"
 #endif
@@ -11,6 +12,10 @@ std::shared_ptr<PoissonSolver> makePoissonSolver(SimulationData& s)
   {
     return std::make_shared<AMRSolver>(s);
   } 
+  else if (s.poissonSolver == "sstep")
+  {
+    return std::make_shared<SStepSolver>(s);
+  }
   else if (s.poissonSolver == "cuda_iterative") 
   {
 #ifdef GPU_POISSON
@@ -117,6 +117,8 @@ void BiCGSTABSolver::freeLast()
     checkCudaErrors(cusparseDestroyDnVec(spDescrLocZ_));
     if (comm_size_ > 1)
     {
+      for (auto & request : send_requests_) MPI_Request_free(&request);
+      for (auto & request : recv_requests_) MPI_Request_free(&request);
       checkCudaErrors(cudaFree(d_send_pack_idx_));
       checkCudaErrors(cudaFree(d_send_buff_));
       checkCudaErrors(cudaFreeHost(h_send_buff_));
@@ -238,6 +240,21 @@ void BiCGSTABSolver::updateAll()
           CUSPARSE_MV_ALG_DEFAULT, 
           &bdSpMVBuffSz_));
     checkCudaErrors(cudaMalloc(&bdSpMVBuff_, bdSpMVBuffSz_ * sizeof(char)));
+
+    // The halo exchange pattern and its host buffers are fixed until the next
+    // update of the linear system: set up persistent requests once
+    const std::vector<int> &recv_ranks = LocalLS_.recv_ranks_;
+    const std::vector<int> &recv_offset = LocalLS_.recv_offset_;
+    const std::vector<int> &recv_sz = LocalLS_.recv_sz_;
+    const std::vector<int> &send_ranks = LocalLS_.send_ranks_;
+    const std::vector<int> &send_offset = LocalLS_.send_offset_;
+    const std::vector<int> &send_sz = LocalLS_.send_sz_;
+    recv_requests_.resize(recv_ranks.size());
+    for (size_t i(0); i < recv_ranks.size(); i++)
+      MPI_Recv_init(&h_recv_buff_[recv_offset[i]], recv_sz[i], MPI_DOUBLE, recv_ranks[i], 978, m_comm_, &recv_requests_[i]);
+    send_requests_.resize(send_ranks.size());
+    for (size_t i(0); i < send_ranks.size(); i++)
+      MPI_Send_init(&h_send_buff_[send_offset[i]], send_sz[i], MPI_DOUBLE, send_ranks[i], 978, m_comm_, &send_requests_[i]);
   }
 
   this->updateVec();
@@ -320,13 +337,6 @@ void BiCGSTABSolver::hd_cusparseSpMV(
   cusparseDnVecDescr_t spDescrRes)
 {
 
-  const std::vector<int> &recv_ranks = LocalLS_.recv_ranks_;
-  const std::vector<int> &recv_offset = LocalLS_.recv_offset_;
-  const std::vector<int> &recv_sz = LocalLS_.recv_sz_;
-  const std::vector<int> &send_ranks = LocalLS_.send_ranks_;
-  const std::vector<int> &send_offset = LocalLS_.send_offset_;
-  const std::vector<int> &send_sz = LocalLS_.send_sz_;
-
   if (comm_size_ > 1)
   {
     send_buff_pack<<<8*56,32, 0, solver_stream_>>>(send_buff_sz_, d_send_pack_idx_, d_send_buff_, d_op_hd);
@@ -358,17 +368,12 @@ void BiCGSTABSolver::hd_cusparseSpMV(
     checkCudaErrors(cudaMemcpyAsync(h_send_buff_, d_send_buff_, send_buff_sz_ * sizeof(double), cudaMemcpyDeviceToHost, copy_stream_));
     checkCudaErrors(cudaStreamSynchronize(copy_stream_));
 
-    // Schedule receives and wait for them to arrive
-    std::vector<MPI_Request> recv_requests(recv_ranks.size());
-    for (size_t i(0); i < recv_ranks.size(); i++)
-      MPI_Irecv(&h_recv_buff_[recv_offset[i]], recv_sz[i], MPI_DOUBLE, recv_ranks[i], 978, m_comm_, &recv_requests[i]);
-
-    std::vector<MPI_Request> send_requests(send_ranks.size());
-    for (size_t i(0); i < send_ranks.size(); i++)
-      MPI_Isend(&h_send_buff_[send_offset[i]], send_sz[i], MPI_DOUBLE, send_ranks[i], 978, m_comm_, &send_requests[i]);
+    // Start the persistent receives and sends and wait for them to complete
+    MPI_Startall(recv_requests_.size(), recv_requests_.data());
+    MPI_Startall(send_requests_.size(), send_requests_.data());
 
-    MPI_Waitall(send_ranks.size(), send_requests.data(), MPI_STATUS_IGNORE);
-    MPI_Waitall(recv_ranks.size(), recv_requests.data(), MPI_STATUS_IGNORE);
+    MPI_Waitall(send_requests_.size(), send_requests_.data(), MPI_STATUSES_IGNORE);
+    MPI_Waitall(recv_requests_.size(), recv_requests_.data(), MPI_STATUSES_IGNORE);
     prof_.stopProfiler("HaloComm", copy_stream_);
 
     // Use solver stream, just in case... even though the halo doesn't particiapte in SpMV race conditions possible due to coalescing?
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <mpi.h>
 
 #include <cublas_v2.h>
@@ -97,6 +98,9 @@ private:
   double* d_send_buff_;
   double* h_send_buff_;
   double* h_recv_buff_;
+  // Persistent halo exchange requests, valid between calls to updateAll
+  std::vector<MPI_Request> send_requests_;
+  std::vector<MPI_Request> recv_requests_;
 
   // Device-side constants
   double* d_consts_;
@@ -0,0 +1,361 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "CoarseCorrection.h"
+#include "AMRSolver.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace cubism;
+
+static long long blockKey(const long long level, const long long ix, const long long iy)
+{
+  return (level << 48) | (ix << 24) | iy;
+}
+
+void CoarseCorrection::build()
+{
+  const std::vector<BlockInfo>& presInfo = sim.pres->getBlocksInfo();
+  const std::vector<BlockInfo>& tmpInfo = sim.tmp->getBlocksInfo();
+  const MPI_Comm comm = sim.chi->getWorldComm();
+  int rank, size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+
+  // (level, index) of all blocks, ordered by rank
+  const int myBlocks = (int) presInfo.size();
+  std::vector<int> mine(3*myBlocks);
+  for (int i = 0; i < myBlocks; i++)
+  {
+    mine[3*i  ] = presInfo[i].level;
+    mine[3*i+1] = presInfo[i].index[0];
+    mine[3*i+2] = presInfo[i].index[1];
+  }
+  counts.resize(size);
+  offsets.resize(size);
+  sim.perf->mpiStart();
+  MPI_Allgather(&myBlocks, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+  sim.perf->mpiStop();
+  std::vector<int> counts3(size), offsets3(size);
+  int Nb = 0;
+  for (int k = 0; k < size; k++)
+  {
+    offsets[k] = Nb;
+    offsets3[k] = 3*Nb;
+    counts3[k] = 3*counts[k];
+    Nb += counts[k];
+  }
+  std::vector<int> all(3*Nb);
+  sim.perf->mpiStart();
+  MPI_Allgatherv(mine.data(), 3*myBlocks, MPI_INT, all.data(), counts3.data(), offsets3.data(), MPI_INT, comm);
+  sim.perf->mpiStop();
+
+  std::unordered_map<long long,int> blocks;
+  for (int g = 0; g < Nb; g++) blocks[blockKey(all[3*g], all[3*g+1], all[3*g+2])] = g;
+
+  // Blocks sharing a face or a corner with each block (at its own, the next
+  // coarser or the next finer level). The LHS of a block only depends on the
+  // values of these blocks.
+  ScalarLab dummy;
+  const bool periodic[2] = {dummy.is_xperiodic(), dummy.is_yperiodic()};
+  std::vector<std::vector<int>> touch(Nb);
+  for (int g = 0; g < Nb; g++)
+  {
+    const int level = all[3*g];
+    const int n[2] = {sim.bpdx << level, sim.bpdy << level};
+    for (int dy = -1; dy <= 1; dy++)
+    for (int dx = -1; dx <= 1; dx++)
+    {
+      if (dx == 0 && dy == 0) continue;
+      int j[2] = {all[3*g+1] + dx, all[3*g+2] + dy};
+      bool outside = false;
+      for (int d = 0; d < 2; d++)
+        if (j[d] < 0 || j[d] >= n[d])
+        {
+          if (periodic[d]) j[d] = (j[d] + n[d]) % n[d];
+          else outside = true;
+        }
+      if (outside) continue;
+
+      auto same = blocks.find(blockKey(level, j[0], j[1]));
+      if (same != blocks.end()) touch[g].push_back(same->second);
+      if (level > 0)
+      {
+        auto coarse = blocks.find(blockKey(level-1, j[0]/2, j[1]/2));
+        if (coarse != blocks.end()) touch[g].push_back(coarse->second);
+      }
+      for (int b = 0; b < 2; b++)
+      for (int a = 0; a < 2; a++)
+      {
+        auto fine = blocks.find(blockKey(level+1, 2*j[0]+a, 2*j[1]+b));
+        if (fine != blocks.end()) touch[g].push_back(fine->second);
+      }
+    }
+  }
+  const std::vector<std::vector<int>> found = touch;
+  for (int g = 0; g < Nb; g++)
+    for (const int h : found[g]) touch[h].push_back(g);
+  for (int g = 0; g < Nb; g++)
+  {
+    std::sort(touch[g].begin(), touch[g].end());
+    touch[g].erase(std::unique(touch[g].begin(), touch[g].end()), touch[g].end());
+  }
+
+  // Greedy coloring in which the blocks touching a common block have
+  // different colors. All ranks compute the same coloring.
+  std::vector<int> color(Nb, -1), stamp;
+  int colors = 0;
+  for (int g = 0; g < Nb; g++)
+  {
+    auto forbid = [&](const int h)
+    {
+      for (const int w : touch[h]) if (color[w] >= 0) stamp[color[w]] = g;
+      if (color[h] >= 0) stamp[color[h]] = g;
+    };
+    stamp.resize(colors+1, -1);
+    forbid(g);
+    for (const int h : touch[g]) forbid(h);
+    int c = 0;
+    while (stamp[c] == g) c++;
+    color[g] = c;
+    colors = std::max(colors, c+1);
+  }
+
+  // Probing: the LHS of the indicator of a color, summed over a block g, is
+  // the coupling of g with the only block of that color it touches.
+  const int offset = offsets[rank];
+  const int BSX = ScalarBlock::sizeX;
+  const int BSY = ScalarBlock::sizeY;
+  const ComputeLHS::LHSkernel kernel(sim);
+  std::vector<double> entries; // (row, column, value) of the local rows
+  for (int c = 0; c < colors; c++)
+  {
+    #pragma omp parallel for
+    for (int i = 0; i < myBlocks; i++)
+      ((ScalarBlock*) presInfo[i].ptrBlock)->set(color[offset+i] == c ? 1 : 0);
+    cubism::compute<ScalarLab>(kernel, sim.pres, sim.tmp);
+
+    for (int i = 0; i < myBlocks; i++)
+    {
+      const int g = offset + i;
+      const ScalarBlock & __restrict__ LHS = *(ScalarBlock*) tmpInfo[i].ptrBlock;
+      double s = 0;
+      for(int iy=0; iy<BSY; ++iy)
+      for(int ix=0; ix<BSX; ++ix)
+        s += LHS(ix,iy).s;
+
+      int h = color[g] == c ? g : -1;
+      for (const int w : touch[g]) if (color[w] == c) h = w;
+      if (h < 0)
+      {
+        if (std::fabs(s) > 1e-3)
+          throw std::runtime_error("CoarseCorrection: the LHS couples blocks that do not touch");
+        continue;
+      }
+      // the coarse operator is stored with the opposite sign
+      if (h == g || std::fabs(s) > 1e-6) entries.insert(entries.end(), {(double)g, (double)h, -s});
+    }
+  }
+
+  const int myEntries = (int) entries.size();
+  std::vector<int> entryCounts(size), entryOffsets(size);
+  sim.perf->mpiStart();
+  MPI_Allgather(&myEntries, 1, MPI_INT, entryCounts.data(), 1, MPI_INT, comm);
+  sim.perf->mpiStop();
+  int allEntries = 0;
+  for (int k = 0; k < size; k++)
+  {
+    entryOffsets[k] = allEntries;
+    allEntries += entryCounts[k];
+  }
+  std::vector<double> allEntriesData(allEntries);
+  sim.perf->mpiStart();
+  MPI_Allgatherv(entries.data(), myEntries, MPI_DOUBLE, allEntriesData.data(), entryCounts.data(), entryOffsets.data(), MPI_DOUBLE, comm);
+  sim.perf->mpiStop();
+
+  std::vector<std::vector<std::pair<int,double>>> K(Nb);
+  for (int k = 0; k < allEntries; k += 3)
+    K[(int) allEntriesData[k]].push_back({(int) allEntriesData[k+1], allEntriesData[k+2]});
+  factor(K);
+
+  rhs.resize(Nb);
+  e.resize(Nb);
+  x.resize(Nb-1);
+  meshVersion = sim.meshVersion;
+}
+
+void CoarseCorrection::factor(const std::vector<std::vector<std::pair<int,double>>> & K)
+{
+  // symmetric pattern of K without the grounded block 0
+  const int Nb = (int) K.size();
+  std::vector<std::vector<int>> adj(Nb);
+  for (int g = 1; g < Nb; g++)
+    for (const auto & entry : K[g])
+      if (entry.first != g && entry.first != 0)
+      {
+        adj[g].push_back(entry.first);
+        adj[entry.first].push_back(g);
+      }
+  for (int g = 0; g < Nb; g++)
+  {
+    std::sort(adj[g].begin(), adj[g].end());
+    adj[g].erase(std::unique(adj[g].begin(), adj[g].end()), adj[g].end());
+  }
+
+  // reverse Cuthill-McKee ordering, started from a pseudo-peripheral block
+  // of every connected component
+  std::vector<char> visited(Nb, 0);
+  visited[0] = 1;
+  std::vector<int> order, next;
+  auto bfs = [&](const int root)
+  {
+    order.assign(1, root);
+    visited[root] = 1;
+    for (size_t k = 0; k < order.size(); k++)
+    {
+      next.clear();
+      for (const int h : adj[order[k]])
+        if (!visited[h])
+        {
+          visited[h] = 1;
+          next.push_back(h);
+        }
+      std::stable_sort(next.begin(), next.end(), [&](const int a, const int b) { return adj[a].size() < adj[b].size(); });
+      order.insert(order.end(), next.begin(), next.end());
+    }
+  };
+  perm.clear();
+  for (int g = 1; g < Nb; g++)
+  {
+    if (visited[g]) continue;
+    bfs(g);
+    const int root = order.back();
+    for (const int h : order) visited[h] = 0;
+    bfs(root);
+    perm.insert(perm.end(), order.rbegin(), order.rend());
+  }
+  const int n = (int) perm.size();
+  std::vector<int> iperm(Nb, -1);
+  for (int i = 0; i < n; i++) iperm[perm[i]] = i;
+
+  // envelope
+  first.resize(n);
+  for (int i = 0; i < n; i++) first[i] = i;
+  for (int g = 1; g < Nb; g++)
+    for (const auto & entry : K[g])
+    {
+      if (entry.first == 0) continue;
+      const int i = iperm[g], j = iperm[entry.first];
+      first[std::max(i,j)] = std::min(first[std::max(i,j)], std::min(i,j));
+    }
+  start.resize(n+1);
+  start[0] = 0;
+  for (int i = 0; i < n; i++) start[i+1] = start[i] + i - first[i];
+  L.assign(start[n], 0);
+  U.assign(start[n], 0);
+  D.assign(n, 0);
+  for (int g = 1; g < Nb; g++)
+    for (const auto & entry : K[g])
+    {
+      if (entry.first == 0) continue;
+      const int i = iperm[g], j = iperm[entry.first];
+      if (i == j) D[i] += entry.second;
+      else if (j < i) L[start[i] + j - first[i]] += entry.second;
+      else U[start[j] + i - first[j]] += entry.second;
+    }
+
+  // Doolittle: row i of L and column i of U from the previous rows/columns
+  for (int i = 0; i < n; i++)
+  {
+    double * const Li = L.data() + start[i] - first[i];
+    double * const Ui = U.data() + start[i] - first[i];
+    for (int j = first[i]; j < i; j++)
+    {
+      const double * const Lj = L.data() + start[j] - first[j];
+      const double * const Uj = U.data() + start[j] - first[j];
+      const int k0 = std::max(first[i], first[j]);
+      double u = Ui[j], l = Li[j];
+      for (int k = k0; k < j; k++)
+      {
+        u -= Lj[k]*Ui[k];
+        l -= Li[k]*Uj[k];
+      }
+      Ui[j] = u;
+      Li[j] = l/D[j];
+    }
+    for (int k = first[i]; k < i; k++) D[i] -= Li[k]*Ui[k];
+    if (!(D[i] > 0))
+      throw std::runtime_error("CoarseCorrection: the coarse operator is not positive on the grounded subspace");
+  }
+}
+
+void CoarseCorrection::solve()
+{
+  // K e = rhs in the subspace of zero mean: the rhs is projected, e is
+  // computed with e_0 = 0 and shifted to zero mean. It runs serially so that
+  // all ranks compute the same correction.
+  const int Nb = (int) rhs.size();
+  const int n = (int) perm.size();
+  double mean = 0;
+  for (int g = 0; g < Nb; g++) mean += rhs[g];
+  mean /= Nb;
+  for (int i = 0; i < n; i++)
+  {
+    const double * const Li = L.data() + start[i] - first[i];
+    double s = rhs[perm[i]] - mean;
+    for (int j = first[i]; j < i; j++) s -= Li[j]*x[j];
+    x[i] = s;
+  }
+  for (int i = n-1; i >= 0; i--)
+  {
+    const double * const Ui = U.data() + start[i] - first[i];
+    x[i] /= D[i];
+    for (int j = first[i]; j < i; j++) x[j] -= Ui[j]*x[i];
+  }
+  e[0] = 0;
+  for (int i = 0; i < n; i++) e[perm[i]] = x[i];
+  mean = 0;
+  for (int g = 0; g < Nb; g++) mean += e[g];
+  mean /= Nb;
+  for (int g = 0; g < Nb; g++) e[g] -= mean;
+}
+
+void CoarseCorrection::apply(const std::vector<Real> & input, std::vector<Real> & output)
+{
+  if (meshVersion != sim.meshVersion) build();
+
+  const MPI_Comm comm = sim.chi->getWorldComm();
+  const int BS2 = VectorBlock::sizeX*VectorBlock::sizeY;
+  const int myBlocks = (int) sim.pres->getBlocksInfo().size();
+  int rank;
+  MPI_Comm_rank(comm, &rank);
+
+  // restriction: sum of the residual over each block
+  std::vector<Real> sums(myBlocks);
+  #pragma omp parallel for
+  for (int i = 0; i < myBlocks; i++)
+  {
+    Real s = 0;
+    for (int k = 0; k < BS2; k++) s += input[i*BS2+k];
+    sums[i] = s;
+  }
+  sim.perf->mpiStart();
+  MPI_Allgatherv(sums.data(), myBlocks, MPI_Real, rhs.data(), counts.data(), offsets.data(), MPI_Real, comm);
+  sim.perf->mpiStop();
+
+  // The fine operator is the (negative semi-definite) Laplacian, the coarse
+  // one is stored with the opposite sign, hence the correction is -e.
+  solve();
+
+  const int offset = offsets[rank];
+  #pragma omp parallel for
+  for (int i = 0; i < myBlocks; i++)
+  {
+    const Real c = e[offset+i];
+    for (int k = 0; k < BS2; k++) output[i*BS2+k] -= c;
+  }
+}
@@ -0,0 +1,61 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#pragma once
+
+#include "../SimulationData.h"
+
+/*
+ * Additive coarse-grid correction for the block-Jacobi preconditioner of
+ * AMRSolver (-poissonCoarseCorrection 1), with one unknown per block.
+ *
+ * The residual is summed over each block (restriction R), a coarse problem
+ * on the block graph is solved, and its solution is added to all cells of the
+ * block (piecewise-constant prolongation P = R^T). The coarse operator is the
+ * Galerkin product R A P of the LHS of AMRSolver (ComputeLHS::LHSkernel, the
+ * unscaled 5-point stencil with the coarse-fine interpolation and the flux
+ * correction; the mean constraint is not included). It is computed by
+ * probing: the blocks are colored so that no two blocks of the same color
+ * touch a common block, the LHS is applied to the indicator of each color and
+ * the result is summed per block. This costs one LHS per color (about 10 on
+ * a uniform grid, up to about 25 with refinement) and uses sim.pres and
+ * sim.tmp as scratch, like AMRSolver::_lhs.
+ *
+ * The coarse problem is replicated on every rank. Its operator is singular
+ * (the pressure is defined up to a constant), so the first block is grounded
+ * and the remaining matrix is factored with an envelope LU (no pivoting,
+ * reverse Cuthill-McKee ordering) in double precision. The factorization is
+ * redone only when the mesh changes (sim.meshVersion); each application costs
+ * one MPI_Allgatherv of the block sums and two triangular solves, and the
+ * correction is projected to zero mean.
+ */
+class CoarseCorrection
+{
+ public:
+  CoarseCorrection(SimulationData& s) : sim(s) {}
+
+  // output += P A_c^{-1} P^T input, for vectors ordered like AMRSolver's
+  // (collective)
+  void apply(const std::vector<Real> & input, std::vector<Real> & output);
+
+ private:
+  SimulationData& sim;
+  int meshVersion = -1;
+  std::vector<int> counts, offsets; // blocks of every rank and first global index
+
+  // envelope LU of the grounded negative coarse operator, in the order perm
+  // (perm[i] is the block of row i, block 0 is grounded and not in perm):
+  // row i of L and column i of U are stored for the columns/rows
+  // [first[i], i), starting at start[i]
+  std::vector<int> perm, first, start;
+  std::vector<double> L, U, D;
+  std::vector<Real> rhs;
+  std::vector<double> x, e;
+
+  void build();
+  void factor(const std::vector<std::vector<std::pair<int,double>>> & K);
+  void solve();
+};
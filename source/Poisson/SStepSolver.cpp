@@ -0,0 +1,494 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "SStepSolver.h"
+
+#include <limits>
+
+using namespace cubism;
+
+// The first count of the points in Leja order: every point maximizes the
+// product of its distances to the ones before, which keeps the Newton basis
+// well conditioned for any prefix.
+static std::vector<Real> lejaOrder(const std::vector<double> &points, const int count)
+{
+  std::vector<Real> ordered;
+  std::vector<bool> used(points.size(), false);
+  for (int k = 0; k < count; k++)
+  {
+    int best = -1;
+    double bestValue = -1;
+    for (size_t j = 0; j < points.size(); j++)
+    {
+      if (used[j]) continue;
+      double value = std::fabs(points[j]);
+      if (k > 0)
+      {
+        value = 1;
+        for (const Real t : ordered) value *= std::fabs(points[j] - t);
+      }
+      if (value > bestValue) { bestValue = value; best = j; }
+    }
+    used[best] = true;
+    ordered.push_back(points[best]);
+  }
+  return ordered;
+}
+
+// Real parts of the eigenvalues of the n x n upper Hessenberg matrix a
+// (row-major), with the shifted QR algorithm. Blocks that do not converge
+// (complex pairs) contribute the real parts of their 2x2 or diagonal
+// entries, which is accurate enough for shifts.
+static std::vector<double> hessenbergEigenvalues(std::vector<double> a, const int n)
+{
+  auto A = [&](const int i, const int j) -> double & { return a[i*n+j]; };
+  const double eps = std::numeric_limits<double>::epsilon();
+  std::vector<double> values;
+  auto bottom = [&](const int i, double &l1, double &l2)
+  {
+    // eigenvalues of the 2x2 block at (i,i), real parts if complex
+    const double p = 0.5*(A(i,i) + A(i+1,i+1));
+    const double d = 0.25*(A(i,i) - A(i+1,i+1))*(A(i,i) - A(i+1,i+1)) + A(i,i+1)*A(i+1,i);
+    l1 = d > 0 ? p + std::sqrt(d) : p;
+    l2 = d > 0 ? p - std::sqrt(d) : p;
+  };
+  int hi = n - 1, iterations = 0;
+  while (hi >= 0)
+  {
+    int lo = hi;
+    while (lo > 0 && std::fabs(A(lo,lo-1)) > eps*(std::fabs(A(lo,lo)) + std::fabs(A(lo-1,lo-1)))) lo--;
+    if (lo == hi)
+    {
+      values.push_back(A(hi,hi));
+      hi --;
+      iterations = 0;
+      continue;
+    }
+    if (lo == hi-1 || iterations == 100)
+    {
+      if (lo == hi-1)
+      {
+        double l1, l2;
+        bottom(lo, l1, l2);
+        values.push_back(l1);
+        values.push_back(l2);
+      }
+      else
+        for (int i = lo; i <= hi; i++) values.push_back(A(i,i));
+      hi = lo - 1;
+      iterations = 0;
+      continue;
+    }
+    iterations ++;
+
+    // QR step with the eigenvalue of the trailing 2x2 block closest to A(hi,hi)
+    double l1, l2;
+    bottom(hi-1, l1, l2);
+    const double mu = std::fabs(l1 - A(hi,hi)) < std::fabs(l2 - A(hi,hi)) ? l1 : l2;
+    for (int i = lo; i <= hi; i++) A(i,i) -= mu;
+    std::vector<double> c(hi-lo), s(hi-lo);
+    for (int k = lo; k < hi; k++)
+    {
+      const double r = std::hypot(A(k,k), A(k+1,k));
+      c[k-lo] = r > 0 ? A(k,k)/r : 1;
+      s[k-lo] = r > 0 ? A(k+1,k)/r : 0;
+      for (int j = k; j <= hi; j++)
+      {
+        const double u = A(k,j), v = A(k+1,j);
+        A(k,j)   =  c[k-lo]*u + s[k-lo]*v;
+        A(k+1,j) = -s[k-lo]*u + c[k-lo]*v;
+      }
+    }
+    for (int k = lo; k < hi; k++)
+      for (int i = lo; i <= std::min(k+1, hi); i++)
+      {
+        const double u = A(i,k), v = A(i,k+1);
+        A(i,k)   =  c[k-lo]*u + s[k-lo]*v;
+        A(i,k+1) = -s[k-lo]*u + c[k-lo]*v;
+      }
+    for (int i = lo; i <= hi; i++) A(i,i) += mu;
+  }
+  return values;
+}
+
+SStepSolver::SStepSolver(SimulationData& ss) :
+  AMRSolver(ss), sstep(ss.poissonSStep), nblocks(ss.poissonSStepBlocks)
+{
+  if (sstep < 1 || nblocks < 1)
+    throw std::invalid_argument("Poisson solver: -poissonSStep and -poissonSStepBlocks must be positive!");
+
+  // Chebyshev points of the interval that contains the spectrum of A M^{-1}:
+  // (0,2] for the block preconditioners, (0,3] with the additive coarse
+  // correction, which adds an A-orthogonal projection.
+  const double upper = sim.bPoissonCoarse ? 3 : 2;
+  std::vector<double> points(sstep);
+  for (int j = 0; j < sstep; j++) points[j] = 0.5*upper*(1 + std::cos(M_PI*(2*j+1)/(2.0*sstep)));
+  theta = lejaOrder(points, sstep);
+
+  const int m = sstep*nblocks;
+  Qb.resize(m+1);
+  Wb.resize(sstep+1);
+  H.resize((m+1)*m);
+}
+
+void SStepSolver::updateShifts(const int steps)
+{
+  const int m = sstep*nblocks;
+  std::vector<double> h(steps*steps);
+  for (int a = 0; a < steps; a++)
+  for (int j = 0; j < steps; j++)
+    h[a*steps+j] = H[a*m+j];
+  theta = lejaOrder(hessenbergEigenvalues(h, steps), sstep);
+}
+
+void SStepSolver::gram(const int nq, const int first, const int nw,
+                       std::vector<double> &C, std::vector<double> &G)
+{
+  // C = Q^T W and G = W^T W for the vectors W[first .. first+nw-1], with a
+  // single pass over the vectors and a single reduction. The small matrices
+  // are kept in double precision even if Real is float.
+  const size_t N = Wb[0].size();
+  const int nC = nq*nw;
+  std::vector<double> all(nC + nw*nw, 0.0);
+  #pragma omp parallel
+  {
+    std::vector<double> local(all.size(), 0.0);
+    #pragma omp for schedule(static)
+    for (size_t p = 0; p < N; p++)
+    {
+      for (int l = 0; l < nq; l++)
+      {
+        const double ql = Qb[l][p];
+        for (int j = 0; j < nw; j++) local[l*nw+j] += ql*Wb[first+j][p];
+      }
+      for (int a = 0; a < nw; a++)
+      {
+        const double wa = Wb[first+a][p];
+        for (int c = a; c < nw; c++) local[nC+a*nw+c] += wa*Wb[first+c][p];
+      }
+    }
+    #pragma omp critical
+    for (size_t e = 0; e < all.size(); e++) all[e] += local[e];
+  }
+  const double t0 = MPI_Wtime();
+  sim.perf->mpiStart();
+  MPI_Allreduce(MPI_IN_PLACE, all.data(), (int)all.size(), MPI_DOUBLE, MPI_SUM, sim.chi->getWorldComm());
+  sim.perf->mpiStop();
+  sim.perf->addPoissonReduction(0, MPI_Wtime() - t0);
+
+  C.assign(all.begin(), all.begin() + nC);
+  G.resize(nw*nw);
+  for (int a = 0; a < nw; a++)
+  for (int c = a; c < nw; c++)
+    G[a*nw+c] = G[c*nw+a] = all[nC+a*nw+c];
+}
+
+int SStepSolver::extend(int &nq, const int s, double &beta)
+{
+  // Generate the next s basis vectors from the last orthonormal vector (or
+  // from the residual in Wb[0] for the first block), orthonormalize them and
+  // extend H. Returns the number of Krylov steps added (<= s).
+  const size_t N = Wb[0].size();
+  const int m = sstep*nblocks;
+  const int first = nq == 0 ? 0 : 1; // the first block also normalizes the residual
+  const int nw = s + 1 - first;
+  if (nq > 0) Wb[0] = Qb[nq-1];
+
+  for (int j = 0; j < s; j++)
+  {
+    _preconditioner(Wb[j], z);
+    _lhs(z, Wb[j+1]);
+    #pragma omp parallel for
+    for (size_t p = 0; p < N; p++) Wb[j+1][p] -= theta[j]*Wb[j][p];
+  }
+
+  std::vector<double> C, G;
+  gram(nq, first, nw, C, G);
+  for (int a = 0; a < nw; a++)
+  for (int c = 0; c < nw; c++)
+  for (int l = 0; l < nq; l++)
+    G[a*nw+c] -= C[l*nw+a]*C[l*nw+c];
+
+  // Cholesky QR, stopped at the first vector that is numerically dependent
+  // on the previous ones
+  const double tiny = 1e4*std::numeric_limits<Real>::epsilon();
+  std::vector<double> R(nw*nw, 0.0);
+  int accepted = 0;
+  for (int i = 0; i < nw; i++)
+  {
+    double d = G[i*nw+i];
+    for (int l = 0; l < i; l++) d -= R[l*nw+i]*R[l*nw+i];
+    if (!(d > tiny*G[i*nw+i])) break;
+    R[i*nw+i] = std::sqrt(d);
+    for (int c = i+1; c < nw; c++)
+    {
+      double v = G[i*nw+c];
+      for (int l = 0; l < i; l++) v -= R[l*nw+i]*R[l*nw+c];
+      R[i*nw+c] = v/R[i*nw+i];
+    }
+    accepted ++;
+  }
+  if (first == 0)
+  {
+    beta = accepted > 0 ? R[0] : 0.0;
+    if (accepted == 0) return 0;
+  }
+  const int added = accepted - 1 + first;
+
+  // new orthonormal vectors: Q_new = (W - Q C) R^{-1}
+  const int nnew = added + 1 - first;
+  #pragma omp parallel for
+  for (size_t p = 0; p < N; p++)
+  for (int c = 0; c < nnew; c++)
+  {
+    double v = Wb[first+c][p];
+    for (int l = 0; l < nq; l++) v -= C[l*nw+c]*Qb[l][p];
+    for (int l = 0; l < c; l++) v -= R[l*nw+c]*Qb[nq+l][p];
+    Qb[nq+c][p] = v/R[c*nw+c];
+  }
+  if (added == 0)
+  {
+    nq += nnew;
+    return 0;
+  }
+
+  // A M^{-1} W_{0..s-1} = W_{0..s} B, with B_jj = theta_j and B_{j+1,j} = 1
+  if (first == 0)
+  {
+    // W = Q R, hence H = R B R^{-1}
+    for (int a = 0; a <= added; a++)
+    for (int j = 0; j < added; j++)
+    {
+      double v = R[a*nw+j]*theta[j] + R[a*nw+j+1];
+      for (int l = 0; l < j; l++) v -= H[a*m+l]*R[l*nw+j];
+      H[a*m+j] = v/R[j*nw+j];
+    }
+    nq = added + 1;
+    return added;
+  }
+
+  // W = [Q, Q_new] T, where w_0 is the last column of Q. The columns of H of
+  // q_{nq-1} and of Q_new are (T B - H_old T) U^{-1}, with U the square block
+  // of T in their rows.
+  const int rows = nq + added;
+  std::vector<double> T(rows*(added+1), 0.0);
+  T[(nq-1)*(added+1)] = 1;
+  for (int j = 1; j <= added; j++)
+  {
+    for (int l = 0; l < nq; l++) T[l*(added+1)+j] = C[l*nw+j-1];
+    for (int i = 0; i < j; i++) T[(nq+i)*(added+1)+j] = R[i*nw+j-1];
+  }
+  std::vector<double> TB(rows*added);
+  for (int a = 0; a < rows; a++)
+  for (int j = 0; j < added; j++)
+  {
+    double v = T[a*(added+1)+j]*theta[j] + T[a*(added+1)+j+1];
+    if (a < nq)
+      for (int l = 0; l < nq-1; l++) v -= H[a*m+l]*T[l*(added+1)+j];
+    TB[a*added+j] = v;
+  }
+  for (int j = 0; j < added; j++)
+  for (int a = 0; a < rows; a++)
+  {
+    double v = TB[a*added+j];
+    for (int l = 0; l < j; l++) v -= H[a*m+nq-1+l]*T[(nq-1+l)*(added+1)+j];
+    H[a*m+nq-1+j] = v/T[(nq-1+j)*(added+1)+j];
+  }
+  nq += added;
+  return added;
+}
+
+double SStepSolver::leastSquares(const int ncols, const double beta, std::vector<double> *y) const
+{
+  // min |beta e_0 - H y| with Givens rotations; returns the residual norm
+  const int m = sstep*nblocks;
+  std::vector<double> h((ncols+1)*ncols);
+  for (int a = 0; a <= ncols; a++)
+  for (int j = 0; j < ncols; j++)
+    h[a*ncols+j] = H[a*m+j];
+  std::vector<double> g(ncols+1, 0.0);
+  g[0] = beta;
+  for (int j = 0; j < ncols; j++)
+  {
+    const double r  = std::hypot(h[j*ncols+j], h[(j+1)*ncols+j]);
+    const double cs = h[j*ncols+j]/r;
+    const double sn = h[(j+1)*ncols+j]/r;
+    for (int l = j; l < ncols; l++)
+    {
+      const double u = h[j*ncols+l];
+      const double v = h[(j+1)*ncols+l];
+      h[j*ncols+l]     =  cs*u + sn*v;
+      h[(j+1)*ncols+l] = -sn*u + cs*v;
+    }
+    g[j+1] = -sn*g[j];
+    g[j]   =  cs*g[j];
+  }
+  if (y != nullptr)
+  {
+    y->resize(ncols);
+    for (int j = ncols-1; j >= 0; j--)
+    {
+      double v = g[j];
+      for (int l = j+1; l < ncols; l++) v -= h[j*ncols+l]*(*y)[l];
+      (*y)[j] = v/h[j*ncols+j];
+    }
+  }
+  return std::fabs(g[ncols]);
+}
+
+SStepSolver::Cycle SStepSolver::cycle(const int maxSteps, const Real max_error, const Real max_rel_error,
+                                      Real &init_norm, int &steps, Real &beta, Real &norm)
+{
+  // One restart cycle from the current x. On return beta is the residual norm
+  // at the start of the cycle and norm the one after the update of x; the
+  // first residual norm of the solve is stored in init_norm.
+  const size_t N = x.size();
+  _lhs(x, Wb[0]);
+  #pragma omp parallel for
+  for (size_t p = 0; p < N; p++) Wb[0][p] = b[p] - Wb[0][p];
+
+  int nq = 0;
+  steps = 0;
+  double beta0 = 0;
+  Real tol = max_error;
+  norm = 0;
+  for (int k = 0; k < nblocks && steps < maxSteps; k++)
+  {
+    const int s = std::min(sstep, maxSteps - steps);
+    const int added = extend(nq, s, beta0);
+    if (k == 0)
+    {
+      beta = beta0;
+      norm = beta0;
+      if (init_norm < 0) init_norm = beta0;
+      tol = std::max(max_error, max_rel_error*init_norm);
+      if (beta0 < tol || beta0 == 0) return Cycle::Converged;
+      if (added == 0) return Cycle::Breakdown;
+    }
+    steps += added;
+    if (added > 0) norm = leastSquares(steps, beta0, nullptr);
+    if (norm < tol || added < s) break;
+  }
+
+  // x += M^{-1} Q y
+  std::vector<double> y;
+  leastSquares(steps, beta0, &y);
+  #pragma omp parallel for
+  for (size_t p = 0; p < N; p++)
+  {
+    double u = 0;
+    for (int j = 0; j < steps; j++) u += y[j]*Qb[j][p];
+    Wb[0][p] = u;
+  }
+  _preconditioner(Wb[0], z);
+  #pragma omp parallel for
+  for (size_t p = 0; p < N; p++) x[p] += z[p];
+
+  return norm < tol ? Cycle::Converged : Cycle::Restart;
+}
+
+void SStepSolver::solve(const ScalarGrid *input, ScalarGrid * const output)
+{
+  if (input != sim.tmp || output != sim.pres)
+    throw std::invalid_argument("SStepSolver hardcoded to sim.tmp and sim.pres for now");
+
+  //Warning: 'input'  initially contains the RHS of the system!
+  //Warning: 'output' initially contains the initial solution guess x0!
+  const auto & AxInfo      = input ->getBlocksInfo();
+  const auto &  zInfo      = output->getBlocksInfo();
+  const size_t Nblocks     = zInfo.size();
+  const int BSX            = VectorBlock::sizeX;
+  const int BSY            = VectorBlock::sizeY;
+  const size_t N           = BSX*BSY*Nblocks;
+  const Real max_error     = sim.step < 10 ? 0.0 : sim.PoissonTol;
+  const Real max_rel_error = sim.step < 10 ? 0.0 : sim.PoissonTolRel;
+  const bool verbose       = sim.rank == 0 && !sim.muteAll;
+
+  b.resize(N);
+  x.resize(N);
+  z.resize(N);
+  for (auto & v : Qb) v.resize(N);
+  for (auto & v : Wb) v.resize(N);
+
+  #pragma omp parallel for
+  for(size_t i=0; i< Nblocks; i++)
+  {
+    ScalarBlock & __restrict__ rhs  = *(ScalarBlock*) AxInfo[i].ptrBlock;
+    const ScalarBlock & __restrict__ zz = *(ScalarBlock*)  zInfo[i].ptrBlock;
+    if( sim.bMeanConstraint == 1)
+      if (isCorner(AxInfo[i])) rhs(0,0).s = 0.0;
+    for(int iy=0; iy<BSY; iy++)
+    for(int ix=0; ix<BSX; ix++)
+    {
+      const int j = i*BSX*BSY+iy*BSX+ix;
+      b[j] = rhs(ix,iy).s;
+      x[j] = zz (ix,iy).s;
+    }
+  }
+
+  Real init_norm = -1;
+  Real norm      = 0;
+  int iterations = 0;
+  int cycles     = 0;
+  int stalls     = 0;
+  bool fallback  = false;
+  while (iterations < sim.maxPoissonIterations)
+  {
+    int steps;
+    Real beta;
+    const Cycle result = cycle(sim.maxPoissonIterations - iterations, max_error, max_rel_error,
+                               init_norm, steps, beta, norm);
+    if (verbose && cycles == 0)
+      std::cout << "[Poisson solver]: initial error norm:" << init_norm << "\n";
+    iterations += steps;
+    cycles ++;
+    if (cycles == 1 && steps >= sstep) updateShifts(steps);
+    if (result == Cycle::Converged)
+    {
+      if (verbose)
+        std::cout << "  [Poisson solver]: Converged after " << iterations << " s-step iterations.\n";
+      break;
+    }
+    if (result == Cycle::Breakdown)
+    {
+      fallback = true;
+      break;
+    }
+    stalls = norm > 0.99*beta ? stalls + 1 : 0;
+    if (stalls == 3)
+    {
+      // with a zero tolerance (first steps) this is the attainable accuracy
+      fallback = norm > 1e-10*init_norm;
+      break;
+    }
+  }
+
+  if (verbose)
+    std::cout <<  " Error norm (relative) = " << norm << "/" << max_error << std::endl;
+  sim.perf->addPoissonSolve(iterations, std::max(cycles-1, 0), init_norm, norm);
+
+  #pragma omp parallel for
+  for(size_t i=0; i< Nblocks; i++)
+  {
+    ScalarBlock& P   = *(ScalarBlock*) zInfo[i].ptrBlock;
+    ScalarBlock& rhs = *(ScalarBlock*) AxInfo[i].ptrBlock;
+    for(int iy=0; iy<BSY; iy++)
+    for(int ix=0; ix<BSX; ix++)
+    {
+      const int j = i*BSX*BSY + iy*BSX + ix;
+      P(ix,iy).s = x[j];
+      if (fallback) rhs(ix,iy).s = b[j]; // the LHS evaluations overwrote the RHS
+    }
+  }
+
+  if (fallback)
+  {
+    if (verbose)
+      std::cout << "  [Poisson solver]: s-step solver stagnated at norm " << norm
+                << ", falling back to the pipelined BiCGSTAB.\n";
+    AMRSolver::solve(input, output);
+  }
+}
@@ -0,0 +1,68 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#pragma once
+
+#include "AMRSolver.h"
+
+/*
+ * Communication-avoiding (s-step) GMRES for the Poisson equation
+ * (-poissonSolver sstep), with the preconditioner and the LHS of AMRSolver.
+ *
+ * Each restart cycle runs up to -poissonSStepBlocks blocks of -poissonSStep
+ * Krylov steps. Within a block the basis vectors are generated with s
+ * preconditioner and LHS applications only (halo exchanges, no global
+ * reductions), using the Newton basis
+ *     w_{j+1} = A M^{-1} w_j - theta_j w_j,
+ * with Leja-ordered shifts theta_j. They are the Chebyshev points of the
+ * interval that contains the eigenvalues of A M^{-1} ((0,2] for the block
+ * preconditioners of the Laplacian, (0,3] with -poissonCoarseCorrection)
+ * until the first cycle of a solve has run, and then the Ritz values of that
+ * cycle (eigenvalues of its Hessenberg matrix), which are kept for the
+ * following solves. The monomial basis would be numerically dependent after
+ * a few steps.
+ * The block is then orthogonalized against the previous ones and made
+ * orthonormal (block Gram-Schmidt + Cholesky QR) with ONE reduction of all
+ * the inner products, the Hessenberg matrix of the Arnoldi relation is
+ * rebuilt from the small factors, and the residual norm of the GMRES least
+ * squares problem is known on every rank without further communication.
+ * Compared to the pipelined BiCGSTAB, which needs two reductions per
+ * iteration, this needs one per s Krylov steps.
+ *
+ * Safeguards: the Cholesky QR stops at the first numerically dependent basis
+ * vector and the cycle is restarted with the vectors accepted so far. If the
+ * first block of a cycle cannot be extended, or the residual stagnates for
+ * three cycles, the solve is finished with AMRSolver::solve from the current
+ * solution.
+ *
+ * An iteration here is one Krylov step (one preconditioner and one LHS
+ * application); a BiCGSTAB iteration of AMRSolver does two of each.
+ */
+class SStepSolver : public AMRSolver
+{
+ public:
+  std::string getName() {
+    return "SStepSolver";
+  }
+  SStepSolver(SimulationData& ss);
+  void solve(const ScalarGrid *input, ScalarGrid *output) override;
+
+ protected:
+  const int sstep;          // Krylov steps per block (one reduction each)
+  const int nblocks;        // blocks per restart cycle
+  std::vector<Real> theta;  // Newton shifts, Leja-ordered
+  std::vector<std::vector<Real>> Qb; // orthonormal basis of the cycle
+  std::vector<std::vector<Real>> Wb; // basis vectors of the current block
+  std::vector<double> H;    // Hessenberg matrix, (m+1) x m, row-major
+
+  enum class Cycle { Converged, Restart, Breakdown };
+  Cycle cycle(int maxSteps, Real max_error, Real max_rel_error, Real &init_norm,
+              int &steps, Real &beta, Real &norm);
+  int extend(int &nq, int s, double &beta);
+  void gram(int nq, int first, int nw, std::vector<double> &C, std::vector<double> &G);
+  double leastSquares(int ncols, double beta, std::vector<double> *y) const;
+  void updateShifts(int steps);
+};
@@ -7,7 +7,6 @@
 #include "Shape.h"
 //#include "OperatorComputeForces.h"
 #include "Utils/BufferedLogger.h"
-#include <gsl/gsl_linalg.h>
 #include <iomanip>
 using namespace cubism;
 
@@ -17,6 +16,32 @@ static constexpr Real EPS = std::numeric_limits<Real>::epsilon();
 Real Shape::getCharMass() const { return 0; }
 Real Shape::getMaxVel() const { return std::sqrt(u*u + v*v); }
 
+// Solve the 3x3 system A x = b by Gaussian elimination with partial pivoting.
+// A and b are overwritten.
+static void solve3x3(double A[3][3], double b[3], double x[3])
+{
+  for (int k = 0; k < 2; k++)
+  {
+    int p = k;
+    for (int i = k+1; i < 3; i++)
+      if (std::fabs(A[i][k]) > std::fabs(A[p][k])) p = i;
+    if (p != k)
+    {
+      for (int j = 0; j < 3; j++) std::swap(A[k][j], A[p][j]);
+      std::swap(b[k], b[p]);
+    }
+    for (int i = k+1; i < 3; i++)
+    {
+      const double f = A[i][k] / A[k][k];
+      for (int j = k; j < 3; j++) A[i][j] -= f * A[k][j];
+      b[i] -= f * b[k];
+    }
+  }
+  x[2] = b[2] / A[2][2];
+  x[1] = (b[1] - A[1][2]*x[2]) / A[1][1];
+  x[0] = (b[0] - A[0][1]*x[1] - A[0][2]*x[2]) / A[0][0];
+}
+
 void Shape::updateVelocity(Real dt)
 {
   #ifdef EXPL_INTEGRATE_MOM
@@ -49,17 +74,12 @@ void Shape::updateVelocity(Real dt)
     A[2][0] = 0; A[2][1] = 0;              b[2] = penalJ * forcedomega;
   }
 
-  gsl_matrix_view Agsl = gsl_matrix_view_array (&A[0][0], 3, 3);
-  gsl_vector_view bgsl = gsl_vector_view_array (b, 3);
-  gsl_vector * xgsl = gsl_vector_alloc (3);
-  int sgsl;
-  gsl_permutation * permgsl = gsl_permutation_alloc (3);
-  gsl_linalg_LU_decomp (& Agsl.matrix, permgsl, & sgsl);
-  gsl_linalg_LU_solve (& Agsl.matrix, permgsl, & bgsl.vector, xgsl);
+  double x[3];
+  solve3x3(A, b, x);
 
-  if(not bForcedx  || sim.time > timeForced)  u     = gsl_vector_get(xgsl, 0);
-  if(not bForcedy  || sim.time > timeForced)  v     = gsl_vector_get(xgsl, 1);
-  if(not bBlockang || sim.time > timeForced)  omega = gsl_vector_get(xgsl, 2);
+  if(not bForcedx  || sim.time > timeForced)  u     = x[0];
+  if(not bForcedy  || sim.time > timeForced)  v     = x[1];
+  if(not bBlockang || sim.time > timeForced)  omega = x[2];
 
   const double tStart = breakSymmetryTime;
   const bool shouldBreak = (sim.time > tStart && sim.time < tStart + 1.0);
@@ -77,9 +97,6 @@ void Shape::updateVelocity(Real dt)
       v = strength * charV * sin( 2*M_PI*(sim.time-tStart) );
     }
   }
-
-  gsl_permutation_free(permgsl);
-  gsl_vector_free(xgsl);
   #endif
 }
 
@@ -159,7 +176,9 @@ Shape::Integrals Shape::integrateObstBlock(const std::vector<BlockInfo>& vInfo)
     }
   }
   Real quantities[7] = {_x,_y,_m,_j,_u,_v,_a};
+  sim.perf->mpiStart();
   MPI_Allreduce(MPI_IN_PLACE, quantities, 7, MPI_Real, MPI_SUM, sim.chi->getWorldComm());
+  sim.perf->mpiStop();
   _x = quantities[0];
   _y = quantities[1];
   _m = quantities[2];
@@ -242,8 +261,16 @@ void Shape::diagnostics()
   */
 }
 
+bool Shape::needsForces() const
+{
+  if (not bForced || forcesRequested || sim._bDump) return true;
+  return forcesFreq > 0 && sim.step % forcesFreq == 0;
+}
+
 void Shape::computeForces()
 {
+  forcesRequested = false;
+
   //additive quantities:
   perimeter = 0; forcex = 0; forcey = 0; forcex_P = 0;
   forcey_P = 0; forcex_V = 0; forcey_V = 0; torque = 0;
@@ -284,7 +311,9 @@ void Shape::computeForces()
   quantities[16] = thrust     ;
   quantities[17] = defPowerBnd;
   quantities[18] = defPower   ;
+  sim.perf->mpiStart();
   MPI_Allreduce(MPI_IN_PLACE, quantities, 19, MPI_Real, MPI_SUM, sim.chi->getWorldComm());
+  sim.perf->mpiStop();
   circulation = quantities[ 0];
   perimeter   = quantities[ 1];
   forcex      = quantities[ 2];
@@ -374,6 +403,7 @@ Shape::Shape( SimulationData& s, ArgumentParser& p, Real C[2] ) :
   forcedv(  -p("-yvel").asDouble(0) ),
   forcedomega(-p("-angvel").asDouble(0)),
   bDumpSurface(p("-dumpSurf").asInt(0)),
+  forcesFreq(p("-forcesFreq").asInt(1)),
   timeForced(p("-timeForced").asDouble(std::numeric_limits<Real>::max())),
   breakSymmetryType(p("-breakSymmetryType").asInt(0)), // 0 is no symmetry breaking
   breakSymmetryStrength(p("-breakSymmetryStrength").asDouble(0.1)),
@@ -437,6 +467,25 @@ void Shape::loadRestart( FILE * f ) {
   d_gm[1]            = in_d_gm1           ;
   center[0]          = in_center0         ;
   center[1]          = in_center1         ;
-  if (sim.rank == 0)
+  if (sim.rank == 0 && !sim.muteAll)
     printf("Restarting Object.. x: %le, y: %le, xlab: %le, ylab: %le, u: %le, v: %le, omega: %le\n", (double)centerOfMass[0], (double)centerOfMass[1], (double)labCenterOfMass[0], (double)labCenterOfMass[1], (double)u, (double)v, (double)omega);
 }
+
+std::string Shape::snapshot()
+{
+  char * buffer = nullptr;
+  size_t size = 0;
+  FILE * f = open_memstream(&buffer, &size);
+  saveRestart(f);
+  fclose(f);
+  std::string state(buffer, size);
+  free(buffer);
+  return state;
+}
+
+void Shape::restore( const std::string & state )
+{
+  FILE * f = fmemopen((void *)state.data(), state.size(), "r");
+  loadRestart(f);
+  fclose(f);
+}
@@ -34,6 +34,7 @@ class Shape
   const Real forcedv;
   const Real forcedomega;
   const bool bDumpSurface;
+  const int forcesFreq; // surface forces every this many steps (0 = on request/dump only)
   const Real timeForced;
   const int breakSymmetryType;
   const Real breakSymmetryStrength;
@@ -59,6 +60,7 @@ class Shape
   Real forcex_V=0, forcey_V=0, torque=0, torque_P=0, torque_V=0;
   Real drag=0, thrust=0, lift=0, circulation=0, Pout=0, PoutNew=0, PoutBnd=0, defPower=0;
   Real defPowerBnd=0, Pthrust=0, Pdrag=0, EffPDef=0, EffPDefBnd=0;
+  bool forcesRequested = false; // set by requestForces, cleared by computeForces
 
   virtual void resetAll()
   {
@@ -169,6 +171,10 @@ class Shape
   virtual void saveRestart( FILE * f );
   virtual void loadRestart( FILE * f );
 
+  //in-memory copy of the restart state (Simulation::snapshot and restore)
+  virtual std::string snapshot();
+  virtual void restore( const std::string & state );
+
   struct Integrals {
     const Real x, y, m, j, u, v, a;
     Integrals(Real _x, Real _y, Real _m, Real _j, Real _u, Real _v, Real _a) :
@@ -188,4 +194,13 @@ class Shape
   void diagnostics();
 
   virtual void computeForces();
+
+  // Surface forces are needed at this step: always for free-swimming shapes
+  // (their dynamics depend on them), otherwise every `forcesFreq` steps, when
+  // fields are dumped or after requestForces. Depends only on replicated
+  // state, hence gives the same answer on all ranks.
+  virtual bool needsForces() const;
+
+  // Ask for the surface forces to be computed at the next step.
+  void requestForces() { forcesRequested = true; }
 };
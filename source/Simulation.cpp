@@ -17,6 +17,7 @@
 #include "Operators/AdaptTheMesh.h"
 #include "Operators/Forcing.h"
 
+#include "Utils/BufferedLogger.h"
 #include "Utils/FactoryFileLineParser.h"
 #include "Utils/StackTrace.h"
 
@@ -36,7 +37,9 @@
 #include "Obstacles/CylinderNozzle.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iterator>
+#include <unordered_map>
 
 // to test reward function of windmill
 // #include <random>
@@ -129,6 +132,11 @@ void Simulation::init()
     randomIC ic(sim);
     ic(0);
   }
+  else if( sim.ic == "taylorGreen" )
+  {
+    taylorGreenIC ic(sim);
+    ic(0);
+  }
   else
   {
     IC ic(sim);
@@ -193,6 +201,10 @@ void Simulation::parseRuntime()
   // boolean to switch between refinement according to chi or grad(chi)
   sim.bAdaptChiGradient = parser("-bAdaptChiGradient").asInt(1);
 
+  // distribute the midline computation of the fish over the ranks (the gait
+  // state is still advanced on every rank, see FishData::distributeMidline)
+  sim.bDistributeMidlines = parser("-bDistributeMidlines").asInt(0);
+
   // initial level of refinement
   sim.levelStart = parser("-levelStart").asInt(-1);
   if (sim.levelStart == -1) sim.levelStart = sim.levelMax - 1;
@@ -238,14 +250,24 @@ void Simulation::parseRuntime()
 
   // poisson solver parameters
   sim.poissonSolver = parser("-poissonSolver").asString("iterative");
+  sim.poissonPreconditioner = parser("-poissonPreconditioner").asString("cholesky");
+  sim.poissonPolyDegree = parser("-poissonPolyDegree").asInt(8);
+  sim.bPoissonCoarse = parser("-poissonCoarseCorrection").asBool(false);
+  sim.poissonProgressBatch = parser("-poissonProgressBatch").asInt(16);
+  sim.poissonSStep = parser("-poissonSStep").asInt(8);
+  sim.poissonSStepBlocks = parser("-poissonSStepBlocks").asInt(8);
   sim.PoissonTol = parser("-poissonTol").asDouble(1e-6);
   sim.PoissonTolRel = parser("-poissonTolRel").asDouble(0);
   sim.maxPoissonRestarts = parser("-maxPoissonRestarts").asInt(30);
   sim.maxPoissonIterations = parser("-maxPoissonIterations").asInt(1000);
   sim.bMeanConstraint = parser("-bMeanConstraint").asInt(0);
+  sim.bAdaptivePoissonTol = parser("-bAdaptivePoissonTol").asBool(false);
+  sim.PoissonTolMax = parser("-poissonTolMax").asDouble(100*sim.PoissonTol);
+  sim.PoissonTolFactor = parser("-poissonTolFactor").asDouble(0.1);
 
   // output parameters
   sim.profilerFreq = parser("-profilerFreq").asInt(0);
+  sim.perf->freq = parser("-perfReportFreq").asInt(0);
   sim.dumpFreq = parser("-fdump").asInt(0);
   sim.dumpTime = parser("-tdump").asDouble(0);
   sim.path2file = parser("-file").asString("./");
@@ -355,6 +377,208 @@ void Simulation::resetRL()
   ic(0);
 }
 
+static long long blockKey(const long long level, const long long ix, const long long iy)
+{
+  return (level << 48) | (ix << 24) | iy;
+}
+
+// grids stored in a snapshot and the size of their blocks, in record order
+static std::vector<std::pair<std::vector<BlockInfo>*, size_t>> snapshotGrids(SimulationData & sim)
+{
+  std::vector<std::pair<std::vector<BlockInfo>*, size_t>> grids = {
+    {&sim.chi ->getBlocksInfo(), sizeof(ScalarBlock)},
+    {&sim.pres->getBlocksInfo(), sizeof(ScalarBlock)},
+    {&sim.pold->getBlocksInfo(), sizeof(ScalarBlock)},
+    {&sim.tmp ->getBlocksInfo(), sizeof(ScalarBlock)},
+    {&sim.vel ->getBlocksInfo(), sizeof(VectorBlock)},
+    {&sim.vOld->getBlocksInfo(), sizeof(VectorBlock)},
+    {&sim.tmpV->getBlocksInfo(), sizeof(VectorBlock)}};
+  if( sim.smagorinskyCoeff != 0 )
+    grids.push_back({&sim.Cs->getBlocksInfo(), sizeof(ScalarBlock)});
+  return grids;
+}
+
+std::shared_ptr<SimulationSnapshot> Simulation::snapshot()
+{
+  auto snap = std::make_shared<SimulationSnapshot>();
+  snap->time          = sim.time;
+  snap->dt            = sim.dt;
+  snap->dt_old        = sim.dt_old;
+  snap->dt_old2       = sim.dt_old2;
+  snap->lambda        = sim.lambda;
+  snap->uinfx         = sim.uinfx;
+  snap->uinfy         = sim.uinfy;
+  snap->uinfx_old     = sim.uinfx_old;
+  snap->uinfy_old     = sim.uinfy_old;
+  snap->uMax_measured = sim.uMax_measured;
+  snap->nextDumpTime  = sim.nextDumpTime;
+  snap->step          = sim.step;
+  snap->bDump         = sim._bDump;
+
+  // copy the blocks of all grids
+  const auto grids = snapshotGrids(sim);
+  size_t record = 0;
+  for (const auto & grid : grids) record += grid.second;
+  const std::vector<BlockInfo>& infos = sim.vel->getBlocksInfo();
+  const int myBlocks = (int) infos.size();
+  std::vector<long long> mine(myBlocks);
+  snap->data.resize(record * myBlocks);
+  #pragma omp parallel for
+  for (int i = 0; i < myBlocks; i++)
+  {
+    mine[i] = blockKey(infos[i].level, infos[i].index[0], infos[i].index[1]);
+    char * dst = snap->data.data() + i * record;
+    for (const auto & grid : grids)
+    {
+      memcpy(dst, (*grid.first)[i].ptrBlock, grid.second);
+      dst += grid.second;
+    }
+  }
+
+  // mesh of all ranks
+  int size;
+  MPI_Comm_size(sim.comm, &size);
+  std::vector<int> counts(size);
+  MPI_Allgather(&myBlocks, 1, MPI_INT, counts.data(), 1, MPI_INT, sim.comm);
+  snap->offsets.assign(size + 1, 0);
+  for (int r = 0; r < size; r++) snap->offsets[r+1] = snap->offsets[r] + counts[r];
+  snap->blocks.resize(snap->offsets[size]);
+  MPI_Allgatherv(mine.data(), myBlocks, MPI_LONG_LONG, snap->blocks.data(), counts.data(), snap->offsets.data(), MPI_LONG_LONG, sim.comm);
+
+  for (const auto & shape : sim.shapes)
+    snap->shapes.push_back(shape->snapshot());
+  return snap;
+}
+
+void Simulation::restore(const SimulationSnapshot & snap)
+{
+  int size;
+  MPI_Comm_size(sim.comm, &size);
+  if ((int) snap.offsets.size() != size + 1)
+    throw std::runtime_error("snapshot was taken with a different number of ranks");
+  if (snap.shapes.size() != sim.shapes.size())
+    throw std::runtime_error("snapshot was taken with a different number of shapes");
+  AdaptTheMesh * const adaptTheMesh = findOperator<AdaptTheMesh>();
+  PutObjectsOnGrid * const putObjectsOnGrid = findOperator<PutObjectsOnGrid>();
+  if (adaptTheMesh == nullptr || putObjectsOnGrid == nullptr)
+    throw std::runtime_error("restore() requires init() to be called first");
+
+  // 1. Refine/compress the mesh until its leaf blocks are those of the
+  // snapshot. A block that is not a leaf of the snapshot is compressed if
+  // the snapshot has a coarser block at its place and refined otherwise; the
+  // 2:1 balance may delay some of the changes to the next pass.
+  std::unordered_map<long long, int> target;
+  target.reserve(snap.blocks.size());
+  for (size_t g = 0; g < snap.blocks.size(); g++) target[snap.blocks[g]] = (int) g;
+  for (int pass = 0; ; pass++)
+  {
+    int changes = 0;
+    for (auto & info : sim.tmp->getBlocksInfo())
+    {
+      info.state = cubism::Leave;
+      if (target.count(blockKey(info.level, info.index[0], info.index[1]))) continue;
+      info.state = cubism::Refine;
+      for (int level = info.level - 1; level >= 0; level--)
+      {
+        const int shift = info.level - level;
+        if (target.count(blockKey(level, info.index[0] >> shift, info.index[1] >> shift)))
+        {
+          info.state = cubism::Compress;
+          break;
+        }
+      }
+      changes++;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &changes, 1, MPI_INT, MPI_SUM, sim.comm);
+    if (changes == 0) break;
+    if (pass == 4*sim.levelMax)
+      throw std::runtime_error("could not restore the mesh of the snapshot");
+    adaptTheMesh->adaptTagged();
+  }
+
+  // 2. Fetch the record of every local block from the rank that stored it.
+  const auto grids = snapshotGrids(sim);
+  size_t record = 0;
+  for (const auto & grid : grids) record += grid.second;
+  const std::vector<BlockInfo>& infos = sim.vel->getBlocksInfo();
+  const int myBlocks = (int) infos.size();
+  std::vector<int> source(myBlocks), sendCounts(size, 0);
+  std::vector<int> position(myBlocks); // in the records of the source
+  for (int i = 0; i < myBlocks; i++)
+  {
+    const int g = target.at(blockKey(infos[i].level, infos[i].index[0], infos[i].index[1]));
+    source[i] = (int) (std::upper_bound(snap.offsets.begin(), snap.offsets.end(), g) - snap.offsets.begin()) - 1;
+    position[i] = g - snap.offsets[source[i]];
+    sendCounts[source[i]]++;
+  }
+  std::vector<int> sendOffsets(size, 0);
+  for (int r = 1; r < size; r++) sendOffsets[r] = sendOffsets[r-1] + sendCounts[r-1];
+  std::vector<int> request(myBlocks), destination(myBlocks);
+  std::vector<int> next = sendOffsets;
+  for (int i = 0; i < myBlocks; i++)
+  {
+    const int k = next[source[i]]++;
+    request[k] = position[i];
+    destination[k] = i;
+  }
+
+  std::vector<int> recvCounts(size), recvOffsets(size, 0);
+  MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, sim.comm);
+  for (int r = 1; r < size; r++) recvOffsets[r] = recvOffsets[r-1] + recvCounts[r-1];
+  std::vector<int> requested(recvOffsets[size-1] + recvCounts[size-1]);
+  MPI_Alltoallv(request.data(), sendCounts.data(), sendOffsets.data(), MPI_INT,
+                requested.data(), recvCounts.data(), recvOffsets.data(), MPI_INT, sim.comm);
+
+  std::vector<char> answer(requested.size() * record);
+  #pragma omp parallel for
+  for (size_t k = 0; k < requested.size(); k++)
+    memcpy(answer.data() + k * record, snap.data.data() + (size_t) requested[k] * record, record);
+  MPI_Datatype recordType;
+  MPI_Type_contiguous((int) record, MPI_BYTE, &recordType);
+  MPI_Type_commit(&recordType);
+  std::vector<char> records(myBlocks * record);
+  MPI_Alltoallv(answer.data(), recvCounts.data(), recvOffsets.data(), recordType,
+                records.data(), sendCounts.data(), sendOffsets.data(), recordType, sim.comm);
+  MPI_Type_free(&recordType);
+
+  // 3. Time stepping state and shapes. The obstacle blocks of the shapes are
+  // rebuilt on the restored mesh with create(), which also advances their
+  // midline and controllers for the snapshot time, as the next step does
+  // again. The shapes are therefore restored once more afterwards, and the
+  // grids (chi included) are copied back last.
+  sim.time          = snap.time;
+  sim.dt            = snap.dt;
+  sim.dt_old        = snap.dt_old;
+  sim.dt_old2       = snap.dt_old2;
+  sim.lambda        = snap.lambda;
+  sim.uinfx         = snap.uinfx;
+  sim.uinfy         = snap.uinfy;
+  sim.uinfx_old     = snap.uinfx_old;
+  sim.uinfy_old     = snap.uinfy_old;
+  sim.uMax_measured = snap.uMax_measured;
+  sim.nextDumpTime  = snap.nextDumpTime;
+  sim.step          = snap.step;
+  sim._bDump        = snap.bDump;
+  sim.invalidateH();
+  sim.invalidateVel();
+  for (size_t s = 0; s < sim.shapes.size(); s++)
+    sim.shapes[s]->restore(snap.shapes[s]);
+  putObjectsOnGrid->putObjectsOnGrid();
+  for (size_t s = 0; s < sim.shapes.size(); s++)
+    sim.shapes[s]->restore(snap.shapes[s]);
+
+  #pragma omp parallel for
+  for (int k = 0; k < myBlocks; k++)
+  {
+    const char * src = records.data() + k * record;
+    for (const auto & grid : grids)
+    {
+      memcpy((*grid.first)[destination[k]].ptrBlock, src, grid.second);
+      src += grid.second;
+    }
+  }
+}
+
 void Simulation::startObstacles()
 {
   Checker check (sim);
@@ -418,6 +642,9 @@ void Simulation::simulate() {
         sim.printResetProfiler();
         std::cout << kHorLine;
       }
+      // the buffered logs would otherwise only be written at exit, which
+      // matters when simulate is called from Python
+      logger.flush();
       break;
     }
   }
@@ -428,9 +655,11 @@ Real Simulation::calcMaxTimestep()
   sim.dt_old2 = sim.dt_old;
   sim.dt_old = sim.dt;
   Real CFL = sim.CFL;
+  sim.perf->startOperator("calcMaxTimestep");
   const Real h = sim.getH();
   const auto findMaxU_op = findMaxU(sim);
   sim.uMax_measured = findMaxU_op.run();
+  sim.perf->stopOperator();
 
   if( CFL > 0 )
   {
@@ -486,8 +715,21 @@ void Simulation::advance(const Real dt)
   for (size_t c=0; c<pipeline.size(); c++) {
     if( sim.rank == 0 && sim.verbose )
       std::cout << "[CUP2D] running " << pipeline[c]->getName() << "...\n";
+    if (pipeline[c]->writes() & OP_VEL) sim.invalidateVel();
+    sim.perf->startOperator(pipeline[c]->getName());
     (*pipeline[c])(dt);
+    sim.perf->stopOperator();
   }
+
+  if (sim.perf->due(sim.step))
+  {
+    const auto & infos = sim.vel->getBlocksInfo();
+    std::vector<int> levels(infos.size());
+    for (size_t i = 0; i < infos.size(); i++) levels[i] = infos[i].level;
+    sim.perf->report(sim.comm, sim.step, sim.time, dt, levels, sim.levelMax, sim.path2file);
+  }
+  sim.perf->endStep();
+
   sim.time += dt;
   sim.step++;
 }
@@ -9,6 +9,29 @@
 #include "SimulationData.h"
 #include "Operator.h"
 
+/// In-memory copy of the state of a simulation (mesh, fields, shapes, time),
+/// see Simulation::snapshot. Every rank keeps the data of its own blocks.
+struct SimulationSnapshot
+{
+  // time stepping state of SimulationData
+  Real time, dt, dt_old, dt_old2, lambda;
+  Real uinfx, uinfy, uinfx_old, uinfy_old;
+  Real uMax_measured, nextDumpTime;
+  int step;
+  bool bDump;
+
+  // leaf blocks of all ranks as (level, index) keys, ordered by rank, and the
+  // first block of every rank
+  std::vector<long long> blocks;
+  std::vector<int> offsets;
+
+  // one record with all the grids for every local block
+  std::vector<char> data;
+
+  // state of every shape (Shape::snapshot)
+  std::vector<std::string> shapes;
+};
+
 class Simulation
 {
  public:
@@ -46,6 +69,15 @@ public:
 
   void reset();
   void resetRL();
+
+  /// Copy the state of the simulation to memory (collective).
+  std::shared_ptr<SimulationSnapshot> snapshot();
+
+  /// Return to a snapshot taken with the same number of ranks (collective).
+  /// The mesh is refined/compressed to the blocks of the snapshot without
+  /// interpolation, the blocks are copied back (moved between ranks if the
+  /// load balancer placed them elsewhere) and the shapes are put on the grid.
+  void restore(const SimulationSnapshot & snap);
   void init();
   void startObstacles();
   void simulate();
@@ -20,6 +20,7 @@ void SimulationData::addShape(std::shared_ptr<Shape> shape) {
 void SimulationData::resetAll()
 {
   for(const auto& shape : shapes) shape->resetAll();
+  invalidateVel();
   time = 0;
   step = 0;
   uinfx = 0;
@@ -110,6 +111,39 @@ void SimulationData::dumpCs(std::string name)
 }
 
 
+ssize_t SimulationData::holdingBlockID(const std::array<Real,2> & pos)
+{
+  const std::vector<BlockInfo>& infos = vel->getBlocksInfo();
+  // the size check covers grids that were modified without invalidateH
+  // (initial setup, restart)
+  if (blockLookupVersion != meshVersion || blockLookup.size() != infos.size())
+  {
+    blockLookup.clear();
+    blockLookup.reserve(infos.size());
+    for (size_t i = 0; i < infos.size(); i++)
+    {
+      const long long key = ((long long)infos[i].level << 48) | ((long long)infos[i].index[0] << 24) | infos[i].index[1];
+      blockLookup[key] = (int) i;
+    }
+    blockLookupVersion = meshVersion;
+  }
+
+  if (pos[0] < 0 || pos[1] < 0 || pos[0] > extents[0] || pos[1] > extents[1]) return -1;
+
+  // the leaf blocks cover the domain, hence at most one level has a block
+  // with the index of the point
+  for (long long level = 0; level < levelMax; level++)
+  {
+    const int n[2] = {bpdx << level, bpdy << level};
+    const Real width = extents[0] / n[0];
+    const long long ix = std::min((int) (pos[0] / width), n[0] - 1);
+    const long long iy = std::min((int) (pos[1] / width), n[1] - 1);
+    const auto block = blockLookup.find((level << 48) | (ix << 24) | iy);
+    if (block != blockLookup.end()) return block->second;
+  }
+  return -1;
+}
+
 void SimulationData::registerDump()
 {
   nextDumpTime += dumpTime;
@@ -119,7 +153,9 @@ SimulationData::SimulationData() = default;
 
 SimulationData::~SimulationData()
 {
+  if (uMaxRequest != MPI_REQUEST_NULL) MPI_Wait(&uMaxRequest, MPI_STATUS_IGNORE);
   delete profiler;
+  delete perf;
   if(vel  not_eq nullptr) delete vel;
   if(chi  not_eq nullptr) delete chi;
   if(pres not_eq nullptr) delete pres;
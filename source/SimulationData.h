@@ -8,7 +8,9 @@
 
 #include "Definitions.h"
 #include "Cubism/Profiler.h"
+#include "Utils/PerfReport.h"
 #include <memory>
+#include <unordered_map>
 
 class Shape;
 
@@ -54,6 +56,9 @@ struct SimulationData
   // boolean to switch between refinement according to chi or grad(chi)
   bool bAdaptChiGradient;
 
+  // compute the midline of every fish on one rank only and share it
+  bool bDistributeMidlines{false};
+
   // maximal simulation extent (direction with max(bpd))
   Real extent;
 
@@ -90,12 +95,21 @@ struct SimulationData
   std::string ic;
 
   // poisson solver parameters
-  std::string poissonSolver;  // for now only "iterative"
+  std::string poissonSolver;  // "iterative", "sstep" or "cuda_iterative"
+  std::string poissonPreconditioner; // "cholesky", "neumann" or "chebyshev"
+  int poissonPolyDegree;      // degree of the polynomial preconditioners
+  bool bPoissonCoarse;        // add a coarse correction with one unknown per block
+  int poissonProgressBatch;   // blocks between MPI progress calls in the preconditioner
+  int poissonSStep;           // Krylov steps per reduction of the s-step solver
+  int poissonSStepBlocks;     // blocks of poissonSStep steps per restart of the s-step solver
   Real PoissonTol;    // absolute error tolerance
   Real PoissonTolRel; // relative error tolerance
   int maxPoissonRestarts; // maximal number of restarts of Poisson solver
   int maxPoissonIterations; // maximal number of iterations of Poisson solver
   int bMeanConstraint; // regularizing the poisson equation using the mean
+  bool bAdaptivePoissonTol; // choose the tolerance per step from the measured divergence
+  Real PoissonTolMax;       // loosest tolerance allowed by the adaptive controller
+  Real PoissonTolFactor;    // tolerance = factor * divergence after the last projection
 
   // output setting
   int profilerFreq = 0;
@@ -111,6 +125,9 @@ struct SimulationData
   // initialize profiler
   cubism::Profiler * profiler = new cubism::Profiler();
 
+  // structured per-step report (JSON lines), written every perf->freq steps
+  PerfReport * perf = new PerfReport();
+
   // declare grids
   ScalarGrid * chi  = nullptr;
   VectorGrid * vel  = nullptr;
@@ -172,18 +189,48 @@ struct SimulationData
   SimulationData& operator=(SimulationData &&) = delete;
   ~SimulationData();
 
-  // minimal gridspacing present on grid
+  // minimal gridspacing present on grid, cached until the mesh changes
   Real getH()
   {
+    if (hGrid > 0) return hGrid;
     Real minHGrid = std::numeric_limits<Real>::infinity();
     auto & infos = vel->getBlocksInfo();
     for (size_t i = 0 ; i< infos.size(); i++)
     {
       minHGrid = std::min((Real)infos[i].h, minHGrid);
     }
+    perf->mpiStart();
     MPI_Allreduce(MPI_IN_PLACE, &minHGrid, 1, MPI_Real, MPI_MIN, comm);
+    perf->mpiStop();
+    hGrid = minHGrid;
     return minHGrid;
   }
+  // must be called whenever blocks are refined or compressed
+  void invalidateH() { hGrid = -1; meshVersion++; }
+  Real hGrid = -1;
+  int meshVersion = 0; // incremented on every mesh change
+  // must be called by everything that writes vel outside of the pipeline
+  // (operators declaring OP_VEL are handled by Simulation::advance)
+  void invalidateVel() { velVersion++; }
+  int velVersion = 0;
+
+  // Index in getBlocksInfo() (the same for all grids) of the local block that
+  // contains pos, -1 if pos belongs to a block of another rank or lies
+  // outside of the domain. Points on a face between two blocks belong to the
+  // block on the upper side, so that exactly one rank owns every point. The
+  // local blocks are hashed on (level, index) when the mesh changes, a query
+  // then costs one lookup per level.
+  ssize_t holdingBlockID(const std::array<Real,2> & pos);
+  std::unordered_map<long long, int> blockLookup;
+  int blockLookupVersion = -1;
+
+  // Velocity maxima {|u+uinfx|, |v+uinfy|, |u|, |v|} measured during the
+  // pressure correction. Their reduction is started there and completed by
+  // findMaxU, which uses them instead of sweeping the grid if the velocity
+  // was not written since then (uMaxVersion == velVersion).
+  Real uMaxPartial[4] = {0, 0, 0, 0};
+  MPI_Request uMaxRequest = MPI_REQUEST_NULL;
+  int uMaxVersion = -1;
 
   void startProfiler(std::string name);
   void stopProfiler();
@@ -0,0 +1,162 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "PerfReport.h"
+#include "BufferedLogger.h"
+
+#include <algorithm>
+#include <iomanip>
+
+void PerfReport::startOperator(const std::string &name)
+{
+  current = -1;
+  for (size_t i = 0; i < ops.size(); i++)
+    if (ops[i].name == name) current = (int)i;
+  if (current < 0)
+  {
+    ops.push_back(OperatorTiming{name});
+    current = (int)ops.size() - 1;
+  }
+  t0 = MPI_Wtime();
+}
+
+void PerfReport::stopOperator()
+{
+  if (current < 0) return;
+  ops[current].wall += MPI_Wtime() - t0;
+  current = -1;
+}
+
+void PerfReport::mpiStart()
+{
+  if (mpiDepth++ == 0) tMPI0 = MPI_Wtime();
+}
+
+void PerfReport::mpiStop()
+{
+  if (--mpiDepth > 0) return;
+  const double dt = MPI_Wtime() - tMPI0;
+  if (current >= 0) ops[current].mpi += dt;
+}
+
+void PerfReport::addPoissonSolve(int iterations, int restarts, double initialResidual, double finalResidual)
+{
+  if (poisson.solves == 0) poisson.initialResidual = initialResidual;
+  poisson.solves ++;
+  poisson.iterations += iterations;
+  poisson.restarts += restarts;
+  poisson.finalResidual = finalResidual;
+}
+
+void PerfReport::addPoissonReduction(double hidden, double wait)
+{
+  poisson.reductions ++;
+  poisson.reductionHidden += hidden;
+  poisson.reductionWait += wait;
+  poisson.reductionWaitMax = std::max(poisson.reductionWaitMax, wait);
+}
+
+void PerfReport::endStep()
+{
+  if (totals.size() < ops.size())
+    for (size_t i = totals.size(); i < ops.size(); i++)
+      totals.push_back(OperatorTiming{ops[i].name});
+  for (size_t i = 0; i < ops.size(); i++)
+  {
+    totals[i].wall += ops[i].wall;
+    totals[i].mpi  += ops[i].mpi;
+    ops[i].wall = ops[i].mpi = 0;
+  }
+  if (poissonTotal.solves == 0) poissonTotal.initialResidual = poisson.initialResidual;
+  poissonTotal.solves     += poisson.solves;
+  poissonTotal.iterations += poisson.iterations;
+  poissonTotal.restarts   += poisson.restarts;
+  poissonTotal.reductions      += poisson.reductions;
+  poissonTotal.reductionHidden += poisson.reductionHidden;
+  poissonTotal.reductionWait   += poisson.reductionWait;
+  poissonTotal.reductionWaitMax = std::max(poissonTotal.reductionWaitMax, poisson.reductionWaitMax);
+  if (poisson.solves > 0) poissonTotal.finalResidual = poisson.finalResidual;
+  poisson = PoissonStats();
+  steps ++;
+}
+
+void PerfReport::resetTotals()
+{
+  for (auto &op : totals) op.wall = op.mpi = 0;
+  poissonTotal = PoissonStats();
+  steps = 0;
+}
+
+void PerfReport::report(MPI_Comm comm, int step, double time, double dt,
+                        const std::vector<int> &blockLevels, int levelMax,
+                        const std::string &path2file) const
+{
+  int rank, size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+
+  // operator timings: [wall..., mpi..., total step time], reduced as max and sum
+  const size_t nOps = ops.size();
+  std::vector<double> local(2*nOps+1, 0.0);
+  for (size_t i = 0; i < nOps; i++)
+  {
+    local[i]      = ops[i].wall;
+    local[nOps+i] = ops[i].mpi;
+    local[2*nOps] += ops[i].wall;
+  }
+  std::vector<double> lmax(local.size()), lsum(local.size());
+  MPI_Reduce(local.data(), lmax.data(), (int)local.size(), MPI_DOUBLE, MPI_MAX, 0, comm);
+  MPI_Reduce(local.data(), lsum.data(), (int)local.size(), MPI_DOUBLE, MPI_SUM, 0, comm);
+
+  // blocks per level (global) and per rank, step time per rank
+  std::vector<long long> levels(levelMax, 0);
+  for (const int l : blockLevels)
+    if (l >= 0 && l < levelMax) levels[l]++;
+  MPI_Reduce(rank == 0 ? MPI_IN_PLACE : levels.data(), levels.data(), levelMax, MPI_LONG_LONG, MPI_SUM, 0, comm);
+
+  const long long myBlocks = (long long)blockLevels.size();
+  std::vector<long long> rankBlocks(rank == 0 ? size : 0);
+  MPI_Gather(&myBlocks, 1, MPI_LONG_LONG, rankBlocks.data(), 1, MPI_LONG_LONG, 0, comm);
+  std::vector<double> rankTime(rank == 0 ? size : 0);
+  MPI_Gather(&local[2*nOps], 1, MPI_DOUBLE, rankTime.data(), 1, MPI_DOUBLE, 0, comm);
+
+  if (rank == 0)
+  {
+    std::stringstream & f = logger.get_stream(path2file + "/perf.jsonl");
+    f << std::setprecision(8);
+    f << "{\"step\":" << step << ",\"time\":" << time << ",\"dt\":" << dt << ",\"ranks\":" << size;
+    f << ",\"wall\":{\"max\":" << lmax[2*nOps] << ",\"avg\":" << lsum[2*nOps]/size << "}";
+    f << ",\"operators\":[";
+    for (size_t i = 0; i < nOps; i++)
+    {
+      const double wallAvg = lsum[i]/size;
+      const double mpiAvg  = lsum[nOps+i]/size;
+      f << (i ? "," : "") << "{\"name\":\"" << ops[i].name << "\""
+        << ",\"wall_max\":" << lmax[i] << ",\"wall_avg\":" << wallAvg
+        << ",\"mpi_max\":" << lmax[nOps+i] << ",\"mpi_avg\":" << mpiAvg
+        << ",\"compute_avg\":" << wallAvg - mpiAvg
+        << ",\"imbalance\":" << (wallAvg > 0 ? lmax[i]/wallAvg : 1.0) << "}";
+    }
+    f << "]";
+    f << ",\"poisson\":{\"solves\":" << poisson.solves
+      << ",\"iterations\":" << poisson.iterations
+      << ",\"restarts\":" << poisson.restarts
+      << ",\"initial_residual\":" << poisson.initialResidual
+      << ",\"final_residual\":" << poisson.finalResidual
+      << ",\"reductions\":" << poisson.reductions
+      << ",\"reduction_hidden\":" << poisson.reductionHidden
+      << ",\"reduction_wait\":" << poisson.reductionWait
+      << ",\"reduction_wait_max\":" << poisson.reductionWaitMax
+      << ",\"reduction_wait_per_iteration\":" << (poisson.iterations ? poisson.reductionWait/poisson.iterations : 0.0) << "}";
+    f << ",\"blocks_per_level\":[";
+    for (int l = 0; l < levelMax; l++) f << (l ? "," : "") << levels[l];
+    f << "],\"blocks_per_rank\":[";
+    for (int r = 0; r < size; r++) f << (r ? "," : "") << rankBlocks[r];
+    f << "],\"time_per_rank\":[";
+    for (int r = 0; r < size; r++) f << (r ? "," : "") << rankTime[r];
+    f << "]}\n";
+  }
+}
@@ -0,0 +1,92 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#pragma once
+
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+/*
+ * Structured per-step performance report.
+ *
+ * Operators are timed with startOperator/stopOperator, explicit MPI calls
+ * are bracketed by mpiStart/mpiStop (time is attributed to the operator
+ * that is currently running) and the Poisson solver reports its iteration
+ * count and residuals. Every `freq` steps the data of the current step is
+ * reduced over all ranks and rank 0 appends one JSON object per line to
+ * `perf.jsonl`. Between reports only a few MPI_Wtime calls are made; the
+ * per-step data is also accumulated into local run totals.
+ *
+ * Note: halo exchanges performed inside cubism::compute are not visible
+ * here and are counted as compute time of the calling operator.
+ */
+class PerfReport
+{
+ public:
+  struct OperatorTiming
+  {
+    std::string name;
+    double wall = 0; // wall time spent in the operator during this step
+    double mpi  = 0; // part of `wall` spent in explicit MPI calls
+  };
+
+  struct PoissonStats
+  {
+    int solves = 0;         // number of solves during this step
+    int iterations = 0;     // total iterations over all solves
+    int restarts = 0;       // total restarts over all solves
+    double initialResidual = 0;
+    double finalResidual = 0;
+    int reductions = 0;            // nonblocking reductions of the solver
+    double reductionHidden = 0;    // time they were overlapped with computation
+    double reductionWait = 0;      // time spent waiting for them (exposed)
+    double reductionWaitMax = 0;   // longest single wait
+  };
+
+  int freq = 0; // write a report every this many steps (0 = disabled)
+
+  bool enabled() const { return freq > 0; }
+  bool due(const int step) const { return freq > 0 && step % freq == 0; }
+
+  void startOperator(const std::string &name);
+  void stopOperator();
+
+  void mpiStart();
+  void mpiStop();
+
+  void addPoissonSolve(int iterations, int restarts, double initialResidual, double finalResidual);
+  void addPoissonReduction(double hidden, double wait);
+
+  // Reduce the timings of this step over all ranks and (on rank 0) append
+  // them to `path2file`/perf.jsonl. Collective, call only if due(step).
+  // `blockLevels` contains the refinement level of every local block.
+  void report(MPI_Comm comm, int step, double time, double dt,
+              const std::vector<int> &blockLevels, int levelMax,
+              const std::string &path2file) const;
+
+  // Add the timings of this step to the run totals and reset them.
+  void endStep();
+
+  // Accumulated (local) timings since construction or resetTotals().
+  const std::vector<OperatorTiming> &getTotals() const { return totals; }
+  const PoissonStats &getPoissonTotals() const { return poissonTotal; }
+  // Poisson statistics of the current step
+  const PoissonStats &getPoisson() const { return poisson; }
+  int getSteps() const { return steps; }
+  void resetTotals();
+
+ private:
+  std::vector<OperatorTiming> ops;
+  PoissonStats poisson;
+  std::vector<OperatorTiming> totals;
+  PoissonStats poissonTotal;
+  int steps = 0;
+  int current = -1;
+  double t0 = 0;
+  double tMPI0 = 0;
+  int mpiDepth = 0;
+};
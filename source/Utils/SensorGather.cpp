@@ -0,0 +1,57 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "SensorGather.h"
+
+size_t SensorGather::addPoint(const std::array<Real,2>& pos, const int n, Probe probe)
+{
+  const size_t offset = addSum(n);
+  points.push_back({pos, offset, std::move(probe)});
+  return offset;
+}
+
+size_t SensorGather::addSum(const int n)
+{
+  const size_t offset = buffer.size();
+  buffer.resize(offset + n, 0);
+  return offset;
+}
+
+void SensorGather::gather()
+{
+  // reduced buffer: values, owners of every point, error flag
+  const size_t N = buffer.size();
+  const size_t P = points.size();
+  std::vector<Real> all(N + P + 1, 0);
+  for(size_t p=0; p<P; ++p)
+  {
+    const ssize_t blockID = sim.holdingBlockID(points[p].pos);
+    if (blockID < 0) continue;
+    all[N + p] = 1;
+    if (!points[p].probe(blockID, points[p].pos, &buffer[points[p].offset]))
+      all[N + P] = 1;
+  }
+  std::copy(buffer.begin(), buffer.end(), all.begin());
+
+  sim.perf->mpiStart();
+  MPI_Allreduce(MPI_IN_PLACE, all.data(), (int) all.size(), MPI_Real, MPI_SUM, sim.comm);
+  sim.perf->mpiStop();
+
+  for(size_t p=0; p<P; ++p)
+    if( sim.rank == 0 && all[N + p] == 0 )
+    {
+      printf("ABORT: coordinate (%g,%g) could not be associated to ANY obstacle block\n", (double)points[p].pos[0], (double)points[p].pos[1]);
+      fflush(0);
+      abort();
+    }
+  if( all[N + P] > 0 )
+  {
+    sim.dumpAll("failed");
+    abort();
+  }
+  std::copy(all.begin(), all.begin() + N, buffer.begin());
+  points.clear();
+}
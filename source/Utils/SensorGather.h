@@ -0,0 +1,68 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#pragma once
+
+#include "../SimulationData.h"
+
+#include <algorithm>
+#include <functional>
+
+/*
+ * Collects sensor values of any number of shapes with a single reduction.
+ *
+ * Shapes register point probes (a position and a function that evaluates
+ * the probe in the block that contains it) and partial sums (e.g. integrals
+ * over a region). gather() evaluates the probes whose point lies on this
+ * rank, with the block lookup of SimulationData, and reduces all values
+ * together with one owner count per point and an error flag in one
+ * MPI_Allreduce. Every point has exactly one owner, so the sum returns its
+ * values on all ranks.
+ *
+ * Usage:
+ *   SensorGather sensors(sim);
+ *   const size_t a = sensors.addPoint(p, 2, probe);
+ *   const size_t b = sensors.addSum(n);
+ *   ... add local contributions to sensors.values(b)[0..n) ...
+ *   sensors.gather();
+ *   ... read sensors.values(a)[0..2) and sensors.values(b)[0..n) ...
+ */
+class SensorGather
+{
+ public:
+  // writes the values of a probe at pos in the local block blockID, returns
+  // false if they cannot be evaluated there
+  using Probe = std::function<bool(ssize_t blockID, const std::array<Real,2>& pos, Real* values)>;
+
+  SensorGather(SimulationData& s) : sim(s) {}
+
+  // registers a probe with n values at pos, returns the offset of its values
+  size_t addPoint(const std::array<Real,2>& pos, int n, Probe probe);
+
+  // registers n values summed over all ranks (initialized to zero), returns
+  // their offset
+  size_t addSum(int n);
+
+  // values starting at offset: local contributions before gather(), reduced
+  // values after it (the pointer is invalidated by the next add, not by
+  // gather)
+  Real * values(size_t offset) { return buffer.data() + offset; }
+
+  // evaluates the local probes and reduces all values (collective). Aborts if
+  // a point is outside of the domain or a probe failed.
+  void gather();
+
+ private:
+  struct Point
+  {
+    std::array<Real,2> pos;
+    size_t offset;
+    Probe probe;
+  };
+  SimulationData& sim;
+  std::vector<Point> points;
+  std::vector<Real> buffer;
+};
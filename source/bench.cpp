@@ -0,0 +1,226 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+// Reproducible performance benchmarks.
+//
+// Every scenario is a fixed set of runtime parameters that is run for a
+// fixed number of steps (after a few warm-up steps that are not timed).
+// For each scenario rank 0 prints one JSON object per line (and appends it to
+// the file given with -benchOutput) with steps/s, per-operator times, Poisson
+// iterations and peak memory.
+//
+// Usage: cubismup2d_bench [-scenarios taylorGreen,disk_L5,...] [-benchSteps 50]
+//                         [-benchWarmup 10] [-benchOutput bench.jsonl]
+//                         [-benchPoissonSolver iterative|sstep]
+//
+// -benchPoissonSolver overrides the Poisson solver of every scenario, to
+// compare the solvers over a range of rank counts.
+//
+// Note: peak memory is the peak resident set size of the process, so to get
+// per-scenario numbers run a single scenario per invocation.
+
+#include "Simulation.h"
+
+#include <sys/resource.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace cubism;
+
+struct BenchScenario
+{
+  std::string name;
+  std::string options;
+  std::string shapes;
+};
+
+static std::vector<BenchScenario> benchScenarios()
+{
+  std::vector<BenchScenario> out;
+
+  // uniform grid, periodic Taylor-Green vortex
+  out.push_back({"taylorGreen",
+    "-bpdx 16 -bpdy 16 -levelMax 1 -levelStart 0 -Rtol 1e9 -Ctol 0 "
+    "-extent 6.283185307179586 -CFL 0.4 -nu 0.01 -ic taylorGreen "
+    "-BC_x periodic -BC_y periodic -poissonTol 1e-6 -poissonTolRel 0", ""});
+
+  // single disk, increasing number of refinement levels
+  for (const int levels : {4, 5, 6})
+  {
+    std::stringstream ss;
+    ss << "-bpdx 16 -bpdy 8 -levelMax " << levels << " -levelStart " << levels-2
+       << " -Rtol 5 -Ctol 0.01 -extent 4 -CFL 0.45 -nu 0.0004"
+       << " -poissonTol 1e-6 -poissonTolRel 0";
+    out.push_back({"disk_L" + std::to_string(levels), ss.str(),
+      "disk radius=0.1 xpos=1.0 bForced=1 bFixed=1 xvel=0.2"});
+  }
+
+  // school of 20 fish (5 columns x 4 rows)
+  {
+    std::stringstream fish;
+    for (int i = 0; i < 5; i++)
+    for (int j = 0; j < 4; j++)
+      fish << "stefanfish L=0.2 T=1 bFixed=1 xpos=" << 0.6 + 0.3*i << " ypos=" << 0.55 + 0.3*j << "\n";
+    out.push_back({"school20",
+      "-bpdx 2 -bpdy 1 -levelMax 7 -levelStart 4 -Rtol 2 -Ctol 1 -extent 4 "
+      "-CFL 0.5 -nu 0.00004 -poissonTol 1e-3 -poissonTolRel 1e-2 -bAdaptChiGradient 0",
+      fish.str()});
+  }
+
+  // forced periodic (Kolmogorov) flow, deterministic initial condition
+  out.push_back({"kolmogorov",
+    "-bpdx 16 -bpdy 16 -levelMax 1 -levelStart 0 -Rtol 0.1 -Ctol 0.01 "
+    "-extent 6.2831853072 -CFL 0.15 -nu 0.05 -bForcing 1 -forcingCoefficient 4 "
+    "-forcingWavenumber 4 -ic taylorGreen -BC_x periodic -BC_y periodic "
+    "-poissonTol 1e-10 -poissonTolRel 0", ""});
+
+  return out;
+}
+
+static std::vector<std::string> splitString(const std::string &s, const char dlm)
+{
+  std::stringstream ss(s); std::string item; std::vector<std::string> tokens;
+  while (std::getline(ss, item, dlm)) if (!item.empty()) tokens.push_back(item);
+  return tokens;
+}
+
+static void runScenario(const BenchScenario &scenario, const std::string &extra,
+                        const int steps, const int warmup,
+                        const std::string &outFile, const int rank, const int size)
+{
+  // build the argument list of the scenario
+  std::vector<std::string> args{"cubismup2d_bench"};
+  std::stringstream opts(scenario.options + " " + extra + " -muteAll 1 -verbose 0 -tdump 0 -fdump 0");
+  std::string token;
+  while (opts >> token) args.push_back(token);
+  if (!scenario.shapes.empty())
+  {
+    args.push_back("-shapes");
+    args.push_back(scenario.shapes);
+  }
+  std::vector<char *> argv;
+  for (auto &a : args) argv.push_back(&a[0]);
+  argv.push_back(nullptr);
+
+  Simulation simulation((int)args.size(), argv.data(), MPI_COMM_WORLD);
+  double tInit = -MPI_Wtime();
+  simulation.init();
+  tInit += MPI_Wtime();
+
+  for (int i = 0; i < warmup; i++) simulation.advance(simulation.calcMaxTimestep());
+  simulation.sim.perf->resetTotals();
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  double tRun = -MPI_Wtime();
+  for (int i = 0; i < steps; i++) simulation.advance(simulation.calcMaxTimestep());
+  MPI_Barrier(MPI_COMM_WORLD);
+  tRun += MPI_Wtime();
+
+  // operator times: max and average over ranks
+  const auto &totals = simulation.sim.perf->getTotals();
+  const size_t nOps = totals.size();
+  std::vector<double> local(2*nOps), tmax(2*nOps), tsum(2*nOps);
+  for (size_t i = 0; i < nOps; i++)
+  {
+    local[i]      = totals[i].wall;
+    local[nOps+i] = totals[i].mpi;
+  }
+  MPI_Reduce(local.data(), tmax.data(), (int)local.size(), MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(local.data(), tsum.data(), (int)local.size(), MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  // peak resident memory (ru_maxrss is in kilobytes on Linux)
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  const double myMem = usage.ru_maxrss / 1024.0;
+  double memMax = 0, memSum = 0;
+  MPI_Reduce(&myMem, &memMax, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(&myMem, &memSum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  long long blocks = simulation.sim.vel->getBlocksInfo().size();
+  MPI_Reduce(rank == 0 ? MPI_IN_PLACE : &blocks, &blocks, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  if (rank != 0) return;
+  const auto &poisson = simulation.sim.perf->getPoissonTotals();
+  std::stringstream f;
+  f << std::setprecision(8);
+  f << "{\"scenario\":\"" << scenario.name << "\""
+    << ",\"poisson_solver\":\"" << simulation.sim.poissonSolver << "\",\"ranks\":" << size
+    << ",\"threads\":" << omp_get_max_threads()
+    << ",\"block_size\":" << VectorBlock::sizeX
+    << ",\"steps\":" << steps << ",\"warmup\":" << warmup
+    << ",\"blocks\":" << blocks
+    << ",\"init_time\":" << tInit << ",\"run_time\":" << tRun
+    << ",\"steps_per_second\":" << steps/tRun;
+  f << ",\"operators\":[";
+  for (size_t i = 0; i < nOps; i++)
+    f << (i ? "," : "") << "{\"name\":\"" << totals[i].name << "\""
+      << ",\"time_max\":" << tmax[i] << ",\"time_avg\":" << tsum[i]/size
+      << ",\"mpi_max\":" << tmax[nOps+i] << ",\"mpi_avg\":" << tsum[nOps+i]/size << "}";
+  f << "]";
+  f << ",\"poisson\":{\"solves\":" << poisson.solves
+    << ",\"iterations\":" << poisson.iterations
+    << ",\"iterations_per_solve\":" << (poisson.solves ? (double)poisson.iterations/poisson.solves : 0.0)
+    << ",\"restarts\":" << poisson.restarts
+    << ",\"reductions\":" << poisson.reductions
+    << ",\"reduction_hidden\":" << poisson.reductionHidden
+    << ",\"reduction_wait\":" << poisson.reductionWait
+    << ",\"reduction_wait_per_iteration\":" << (poisson.iterations ? poisson.reductionWait/poisson.iterations : 0.0) << "}";
+  f << ",\"peak_memory_mb\":{\"max\":" << memMax << ",\"total\":" << memSum << "}}\n";
+
+  std::cout << f.str() << std::flush;
+  if (!outFile.empty())
+  {
+    std::ofstream out(outFile, std::ios::app);
+    out << f.str();
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int threadSafety;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &threadSafety);
+  int rank, size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  ArgumentParser parser(argc, argv);
+  const int steps = parser("-benchSteps").asInt(50);
+  const int warmup = parser("-benchWarmup").asInt(10);
+  const std::string outFile = parser("-benchOutput").asString("bench.jsonl");
+  const std::string which = parser("-scenarios").asString("");
+  const std::string solver = parser("-benchPoissonSolver").asString("");
+  const std::string extra = solver.empty() ? "" : "-poissonSolver " + solver;
+  const std::vector<std::string> selected = splitString(which, ',');
+
+  const std::vector<BenchScenario> scenarios = benchScenarios();
+  for (const auto &name : selected)
+  {
+    bool found = false;
+    for (const auto &s : scenarios) found = found || s.name == name;
+    if (!found)
+    {
+      if (rank == 0)
+      {
+        std::cerr << "unknown scenario '" << name << "', available:";
+        for (const auto &s : scenarios) std::cerr << " " << s.name;
+        std::cerr << std::endl;
+      }
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+
+  for (const auto &s : scenarios)
+  {
+    if (!selected.empty() && std::find(selected.begin(), selected.end(), s.name) == selected.end())
+      continue;
+    runScenario(s, extra, steps, warmup, outFile, rank, size);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,187 @@
+//
+//  CubismUP_2D
+//  Copyright (c) 2021 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+// Microbenchmarks for the hot kernels.
+//
+// A single-rank simulation (MPI_COMM_SELF, uniform mesh, periodic boundaries,
+// Taylor-Green velocity, one disk) provides synthetic blocks; every kernel is
+// then applied `-reps` times through the same driver the operators use. For
+// each kernel rank 0 prints one JSON line with cells/s and bytes/s, where
+// bytes are the compulsory traffic of the kernel (fields read and written
+// once per cell, see `bytesPerCell`). The roofline estimate compares this to
+// the bandwidth of a STREAM-like triad measured at startup. Lab assembly is
+// part of the measured time, except for getZ which works on plain arrays.
+//
+// Usage: cubismup2d_kernel_bench [-bpd 16] [-reps 20] [-benchOutput kernels.jsonl]
+
+#include "Simulation.h"
+#include "Operators/advDiff.h"
+#include "Operators/PressureSingle.h"
+#include "Operators/PutObjectsOnGrid.h"
+#include "Operators/ComputeForces.h"
+#include "Poisson/AMRSolver.h"
+#include "Shape.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace cubism;
+
+// bandwidth of a[i] = b[i] + s*c[i] in bytes/s (best of several repetitions)
+static double streamTriad()
+{
+  const size_t n = 1 << 23;
+  std::vector<double> a(n), b(n), c(n);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; i++) { a[i] = 0; b[i] = 1; c[i] = 2; }
+  double best = 1e100;
+  for (int r = 0; r < 5; r++)
+  {
+    const double t0 = MPI_Wtime();
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; i++) a[i] = b[i] + 0.5*c[i];
+    best = std::min(best, MPI_Wtime() - t0);
+  }
+  if (a[n/2] != 2) std::cerr << "stream triad: unexpected result" << std::endl;
+  return 3.0 * sizeof(double) * n / best;
+}
+
+template <typename F>
+static double timeKernel(F &&f, const int reps)
+{
+  f(); // warm-up
+  const double t0 = MPI_Wtime();
+  for (int r = 0; r < reps; r++) f();
+  return (MPI_Wtime() - t0) / reps;
+}
+
+int main(int argc, char **argv)
+{
+  int threadSafety;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &threadSafety);
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  ArgumentParser parser(argc, argv);
+  const int bpd = parser("-bpd").asInt(16);
+  const int reps = parser("-reps").asInt(20);
+  const std::string outFile = parser("-benchOutput").asString("kernels.jsonl");
+
+  // synthetic single-rank problem
+  std::vector<std::string> args{"cubismup2d_kernel_bench",
+    "-bpdx", std::to_string(bpd), "-bpdy", std::to_string(bpd),
+    "-levelMax", "1", "-levelStart", "0", "-Rtol", "1e9", "-Ctol", "0",
+    "-extent", "1", "-CFL", "0.4", "-nu", "0.001", "-ic", "taylorGreen",
+    "-BC_x", "periodic", "-BC_y", "periodic", "-muteAll", "1", "-verbose", "0",
+    "-shapes", "disk radius=0.2 xpos=0.5 ypos=0.5 bFixed=1"};
+  std::vector<char *> cargs;
+  for (auto &a : args) cargs.push_back(&a[0]);
+  cargs.push_back(nullptr);
+  Simulation simulation((int)args.size(), cargs.data(), MPI_COMM_SELF);
+  simulation.init();
+  simulation.calcMaxTimestep();
+  SimulationData &sim = simulation.sim;
+
+  const double bandwidth = streamTriad();
+  const auto &velInfo = sim.vel->getBlocksInfo();
+  const size_t Nblocks = velInfo.size();
+  const size_t cellsPerBlock = VectorBlock::sizeX * VectorBlock::sizeY;
+  const size_t cells = Nblocks * cellsPerBlock;
+
+  // cells of blocks that intersect the obstacle and its surface points
+  size_t obstacleCells = 0, surfacePoints = 0;
+  for (const auto &shape : sim.shapes)
+  for (const auto *o : shape->obstacleBlocks)
+    if (o != nullptr)
+    {
+      obstacleCells += cellsPerBlock;
+      surfacePoints += o->n_surfPoints;
+    }
+
+  std::stringstream out;
+  out << std::setprecision(6);
+  auto report = [&](const std::string &name, const size_t nCells, const int realsPerCell, const double t)
+  {
+    const double bytesPerCell = realsPerCell * sizeof(Real);
+    const double bytesPerSecond = nCells * bytesPerCell / t;
+    out << "{\"kernel\":\"" << name << "\",\"block_size\":" << VectorBlock::sizeX
+        << ",\"blocks\":" << Nblocks << ",\"threads\":" << omp_get_max_threads()
+        << ",\"cells\":" << nCells << ",\"time\":" << t
+        << ",\"cells_per_second\":" << nCells / t
+        << ",\"bytes_per_cell\":" << bytesPerCell
+        << ",\"bytes_per_second\":" << bytesPerSecond
+        << ",\"stream_bandwidth\":" << bandwidth
+        << ",\"roofline_time\":" << nCells * bytesPerCell / bandwidth
+        << ",\"roofline_fraction\":" << bytesPerSecond / bandwidth << "}\n";
+  };
+
+  // obstacle kernels first: they need the signed distance stored in tmp
+  {
+    const PutChiOnGrid K(sim);
+    const double t = timeKernel([&]{ cubism::compute<ScalarLab>(K, sim.tmp); }, reps);
+    report("PutChiOnGrid", obstacleCells, 5, t); // sdf, lab, chi(obstacle), CHI read+write
+  }
+  {
+    const KernelComputeForces K(sim);
+    const double t = timeKernel([&]{
+      cubism::compute<KernelComputeForces,VectorGrid,VectorLab,ScalarGrid,ScalarLab>(K, *sim.vel, *sim.chi);
+    }, reps);
+    report("KernelComputeForces", obstacleCells, 4, t); // vel, chi, pres
+    out << "{\"kernel\":\"KernelComputeForces\",\"surface_points\":" << surfacePoints
+        << ",\"points_per_second\":" << surfacePoints / t << "}\n";
+  }
+  {
+    const KernelAdvectDiffuse K(sim);
+    const double t = timeKernel([&]{ cubism::compute<VectorLab>(K, sim.vel, sim.tmpV); }, reps);
+    report("KernelAdvectDiffuse", cells, 4, t); // vel read, tmpV write
+  }
+  {
+    const pressureCorrectionKernel K(sim);
+    const double t = timeKernel([&]{ cubism::compute<ScalarLab>(K, sim.pres, sim.tmpV); }, reps);
+    report("pressureCorrectionKernel", cells, 3, t); // pres read, tmpV write
+  }
+  {
+    const double t = timeKernel([&]{ computePressureRHS(sim); }, reps);
+    report("updatePressureRHS", cells, 7, t); // vel, udef, chi, pres read, tmp write
+  }
+  {
+    const ComputeLHS::LHSkernel K(sim);
+    const double t = timeKernel([&]{ cubism::compute<ScalarLab>(K, sim.pres, sim.tmp); }, reps);
+    report("LHSkernel", cells, 2, t); // pres read, tmp write
+  }
+  for (const std::string precond : {"cholesky", "neumann", "chebyshev"})
+  {
+    sim.poissonPreconditioner = precond;
+    AMRSolver solver(sim);
+    std::vector<Real> input(cells), output(cells);
+    const auto &tmpInfo = sim.tmp->getBlocksInfo();
+    #pragma omp parallel for
+    for (size_t i = 0; i < Nblocks; i++)
+    {
+      const ScalarBlock &b = *(ScalarBlock*) tmpInfo[i].ptrBlock;
+      for (int iy = 0; iy < ScalarBlock::sizeY; iy++)
+      for (int ix = 0; ix < ScalarBlock::sizeX; ix++)
+        input[i*cellsPerBlock + iy*ScalarBlock::sizeX + ix] = b(ix,iy).s;
+    }
+    const double t = timeKernel([&]{ solver._preconditioner(input, output); }, reps);
+    const std::string name = precond == "cholesky" ? "AMRSolver::getZ" : "AMRSolver::getZ_" + precond;
+    report(name, cells, 2, t); // input read, output write
+  }
+
+  if (rank == 0)
+  {
+    std::cout << out.str() << std::flush;
+    if (!outFile.empty())
+    {
+      std::ofstream f(outFile, std::ios::app);
+      f << out.str();
+    }
+  }
+
+  MPI_Finalize();
+  return 0;
+}
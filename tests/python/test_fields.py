@@ -84,6 +84,42 @@ class TestFields(TestCase):
     def test_load_uniform_amr_vector_reshuffled(self):
         self._test_load_uniform_amr('vel', (2,), True)
 
+    def test_blocks_data(self):
+        sim = TestSimulation(cells=(128, 64), nlevels=3, start_level=0)
+        sim.add_shape(cup2d.Disk(sim, r=0.1, center=(0.3, 0.25),
+                                 vel=(1.0, 0.0), fixed=True, forced=True))
+        sim.init()
+        sim.simulate(nsteps=1)
+
+        for field, shape in [(sim.fields.chi, ()), (sim.fields.vel, (2,))]:
+            blocks = field.blocks
+            data = blocks.data
+            self.assertEqual(data.shape, (len(blocks), *blocks[0].shape))
+            for k, block in enumerate(blocks):
+                self.assertArrayEqual(data[k], block.data)
+            self.assertArrayEqual(blocks.levels, [b.level for b in blocks])
+            self.assertArrayEqual(blocks.ij, [b.ij for b in blocks])
+            self.assertEqual(blocks.origins.shape, (len(blocks), 2))
+            self.assertEqual(blocks.Z.shape, (len(blocks),))
+
+            # Cell size halves with each level.
+            h0 = blocks.h * 2.0 ** blocks.levels
+            self.assertClose(h0, np.full(len(blocks), h0[0]))
+
+            expected = np.random.uniform(0.0, 1.0, data.shape)
+            blocks.load(expected)
+            self.assertArrayAlmostEqual(blocks.data, expected)
+            for k, block in enumerate(blocks):
+                self.assertArrayAlmostEqual(block.data, expected[k])
+
+            if blocks.contiguous:
+                blocks.data[0] = 5.0
+                self.assertArrayEqual(blocks[0].data, np.full(blocks[0].shape, 5.0))
+            else:
+                with self.assertRaises(ValueError):
+                    blocks.data[0] = 5.0
+
+
 
 class TestExportUniform(TestCase):
     def test_semi_quadratic_interpolation(self):
@@ -0,0 +1,95 @@
+from base import TestCase, cup2d
+
+import numpy as np
+import os
+import tempfile
+
+def make_sim(argv=[], iterations=200, **kwargs):
+    # The tolerance of the Poisson solver is only used from step 10 on.
+    kwargs.setdefault('mute_all', True)
+    sim = cup2d.Simulation(cells=(128, 128), nlevels=3, start_level=1,
+                           argv=['-maxPoissonIterations', iterations] + argv,
+                           **kwargs)
+    sim.add_shape(cup2d.Disk(sim, r=0.1, center=(0.3, 0.5),
+                             vel=(0.5, 0.0), fixed=True, forced=True))
+    sim.init()
+    return sim
+
+
+class TestPoissonCase(TestCase):
+    def assertFieldsClose(self, sim, ref, tol):
+        # tol is relative to the largest value of the reference field; the
+        # pressure is defined up to a constant.
+        for name in ['pres', 'vel']:
+            a = getattr(sim.fields, name).to_uniform(interpolate=False)
+            b = getattr(ref.fields, name).to_uniform(interpolate=False)
+            if name == 'pres':
+                a = a - a.mean()
+                b = b - b.mean()
+            self.assertClose(a, b, rtol=0, atol=tol * np.abs(b).max())
+
+    def test_coarse_correction(self):
+        iterations = []
+        for coarse in [0, 1]:
+            sim = make_sim(['-poissonCoarseCorrection', coarse])
+            sim.simulate(nsteps=10)
+            before = sim.data.poisson_iterations
+            sim.simulate(nsteps=5)
+            iterations.append(sim.data.poisson_iterations - before)
+        self.assertLess(iterations[1], iterations[0])
+
+    def test_preconditioners(self):
+        ref = make_sim(['-poissonPreconditioner', 'cholesky'])
+        ref.simulate(nsteps=12)
+        for preconditioner in ['neumann', 'chebyshev']:
+            sim = make_sim(['-poissonPreconditioner', preconditioner])
+            sim.simulate(nsteps=12)
+            self.assertFieldsClose(sim, ref, tol=1e-3)
+
+    def test_sstep(self):
+        # With and without the coarse correction, which changes the spectrum
+        # the Newton shifts have to cover.
+        for coarse in [0, 1]:
+            argv = ['-poissonCoarseCorrection', coarse]
+            ref = make_sim(argv)
+            ref.simulate(nsteps=12)
+            sim = make_sim(argv + ['-poissonSolver', 'sstep'])
+            sim.simulate(nsteps=12)
+            self.assertFieldsClose(sim, ref, tol=1e-3)
+
+    def run_adaptive_tolerance(self, tol, tol_max, iterations, nsteps):
+        """Returns the rows of poissonTolerance.dat as dicts."""
+        with tempfile.TemporaryDirectory() as output_dir:
+            sim = make_sim(['-bAdaptivePoissonTol', 1, '-poissonTol', tol,
+                            '-poissonTolMax', tol_max],
+                           iterations=iterations, mute_all=False,
+                           verbose=False, output_dir=output_dir + '/')
+            sim.simulate(nsteps=nsteps)
+            path = os.path.join(output_dir, 'poissonTolerance.dat')
+            self.assertTrue(os.path.exists(path))
+            with open(path) as f:
+                lines = f.read().splitlines()
+        header = lines[0].split()
+        self.assertEqual(header[-1], 'reason')
+        rows = [dict(zip(header, line.split())) for line in lines[1:]]
+        self.assertEqual([int(row['step']) for row in rows], list(range(nsteps)))
+        for row in rows:
+            self.assertGreaterEqual(float(row['tol']), tol * (1 - 1e-6))
+            self.assertLessEqual(float(row['tol']), tol_max * (1 + 1e-6))
+        self.assertEqual({row['reason'] for row in rows[:10]}, {'startup'})
+        return rows
+
+    def test_adaptive_tolerance(self):
+        rows = self.run_adaptive_tolerance(1e-6, 1e-3, 200, 20)
+        self.assertTrue({row['reason'] for row in rows[10:]} <=
+                        {'divergence', 'clamped', 'divergence_growth', 'cap_reached'})
+
+    def test_adaptive_tolerance_reset(self):
+        # A tolerance that cannot be reached in 10 iterations: every solve
+        # hits the cap (unless the divergence growth check fires first), and
+        # the tolerance and the cap are reset.
+        rows = self.run_adaptive_tolerance(1e-12, 1e-10, 10, 12)
+        for row in rows[10:]:
+            self.assertIn(row['reason'], ['cap_reached', 'divergence_growth'])
+            self.assertEqual(int(row['cap']), 10)
+            self.assertEqual(float(row['tol']), 1e-12)
@@ -39,3 +39,54 @@ class TestShapes(TestCase):
         self.assertClose(M['2xx'], np.pi / 4 * 5.0 ** 4, rtol=1e-2)
         self.assertClose(M['2yy'], np.pi / 4 * 5.0 ** 4, rtol=1e-2)
         self.assertClose(M['2xy'], 0.0, atol=0.2)
+
+    def test_stefanfish_batched_state(self):
+        sim = TestSimulation(cells=(128, 64), nlevels=4, start_level=2, extent=2.0)
+        fish = [cup2d.StefanFish(sim, pid=0, pidpos=0, center=(0.5 + 0.5 * i, 0.5))
+                for i in range(3)]
+        for f in fish:
+            sim.add_shape(f)
+        sim.init()
+        sim.simulate(nsteps=2)
+
+        origin = [0.2, 0.3]
+        S = cup2d.stefanfish_states(fish, origin)
+        self.assertEqual(S.shape, (3, 16))
+        for i, f in enumerate(fish):
+            self.assertArrayEqual(S[i], f.state(origin))
+
+        actions = np.array([[0.1, 0.5], [-0.1, 0.5], [0.0, 0.5]])
+        cup2d.stefanfish_act(fish, sim.data.time, actions)
+        S = cup2d.stefanfish_states(fish, origin)
+        self.assertArrayAlmostEqual(S[:, 7], actions[:, 1])
+        self.assertArrayAlmostEqual(S[:, 8], actions[:, 0])
+
+    def test_stefanfish_distributed_midlines(self):
+        # Run with `mpirun -n 2 ./run.sh test_shapes`.
+        try:
+            from mpi4py import MPI
+        except ImportError:
+            self.skipTest("mpi4py not available")
+        comm = MPI.COMM_WORLD
+        if comm.size < 2:
+            self.skipTest("requires at least 2 ranks")
+
+        sim = TestSimulation(cells=(128, 64), nlevels=4, start_level=2,
+                             extent=2.0, comm=comm,
+                             argv=['-bDistributeMidlines', '1'])
+        fish = [cup2d.StefanFish(sim, pid=0, pidpos=0, center=(0.5 + 0.5 * i, 0.5))
+                for i in range(3)]
+        for f in fish:
+            sim.add_shape(f)
+        sim.init()
+        sim.simulate(nsteps=2)
+
+        # Change the period to exercise the period transition of the gait.
+        for i, f in enumerate(fish):
+            f.act(sim.data.time, [0.1 * (i - 1), 0.2])
+        sim.simulate(nsteps=5)
+
+        origin = [0.2, 0.3]
+        S = np.array([f.state(origin) for f in fish])
+        for other in comm.allgather(S):
+            self.assertArrayEqual(S, other)
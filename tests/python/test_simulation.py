@@ -33,3 +33,58 @@ class TestSimulationCase(TestCase):
         sim.simulate(nsteps=10)
         sim.adapt_mesh()
         sim.simulate(nsteps=10)
+
+    def test_snapshot_restore(self):
+        sim = TestSimulation(cells=(64, 64), start_level=1, nlevels=3)
+        sim.add_shape(cup2d.Disk(sim, r=0.1, center=(0.3, 0.5),
+                                 vel=(0.5, 0.0), fixed=True, forced=True))
+        sim.init()
+        sim.simulate(nsteps=2)
+        snap = sim.snapshot()
+        vel = sim.fields.vel.to_uniform(interpolate=False)
+        pres = sim.fields.pres.to_uniform(interpolate=False)
+
+        sim.simulate(nsteps=10)
+        sim.adapt_mesh()
+        sim.restore(snap)
+        self.assertEqual(sim.data.step, snap.step)
+        self.assertEqual(sim.data.time, snap.time)
+        self.assertArrayEqual(vel, sim.fields.vel.to_uniform(interpolate=False))
+        self.assertArrayEqual(pres, sim.fields.pres.to_uniform(interpolate=False))
+
+        # The run continues as it would have from the snapshot.
+        sim.simulate(nsteps=3)
+        vel3 = sim.fields.vel.to_uniform(interpolate=False)
+        sim.restore(snap)
+        sim.simulate(nsteps=3)
+        self.assertArrayAlmostEqual(vel3, sim.fields.vel.to_uniform(interpolate=False))
+
+
+    def test_snapshot_restore_stefanfish(self):
+        # Without PID control, with trajectory control and with position
+        # control, whose state is updated in StefanFish::create.
+        sim = TestSimulation(cells=(128, 64), nlevels=4, start_level=2, extent=2.0)
+        fish = [cup2d.StefanFish(sim, pid=0, pidpos=0, center=(0.4, 0.5)),
+                cup2d.StefanFish(sim, pid=1, pidpos=0, center=(0.9, 0.5)),
+                cup2d.StefanFish(sim, pid=0, pidpos=1, center=(1.4, 0.5))]
+        for f in fish:
+            sim.add_shape(f)
+        sim.init()
+        sim.simulate(nsteps=2)
+        snap = sim.snapshot()
+
+        origin = [0.2, 0.3]
+        sim.simulate(nsteps=3)
+        states = [f.state(origin) for f in fish]
+        vel = sim.fields.vel.to_uniform(interpolate=False)
+
+        # A period change after the snapshot must not survive the restore.
+        sim.restore(snap)
+        for f in fish:
+            f.act(sim.data.time, [0.1, 0.3])
+        sim.simulate(nsteps=3)
+        sim.restore(snap)
+        sim.simulate(nsteps=3)
+        for f, state in zip(fish, states):
+            self.assertArrayAlmostEqual(state, f.state(origin))
+        self.assertArrayAlmostEqual(vel, sim.fields.vel.to_uniform(interpolate=False))